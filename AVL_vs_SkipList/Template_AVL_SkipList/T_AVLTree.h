@@ -1,27 +1,52 @@
 #pragma once
+#include <exception>
+#include <future>
 #include <iostream>
-#include <stack>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "T_NodeAllocator.h"
+#include "T_Prefetch.h"
 
-template <class>
+template <class T, class Alloc = SlabAllocator<>>
 class AVLIterator;
 
 /// @brief Self-balancing AVL tree with no repetitions rule
-template <class T>
+/// @tparam Alloc Node allocator policy (see T_NodeAllocator.h)
+template <class T, class Alloc = SlabAllocator<>>
 class AVLTree {
 private:
 	/// @brief Tree node structure that keeps value and children pointers
 	struct Node {
 		/// @brief Value of the node 
 		T value;
+		/// @brief Height of the left subtree minus height of the right one (-1, 0 or 1).
+		/// Kept in 2 bits next to the value instead of a full height so the node stays small
+		signed int balance : 2;
+		/// @brief Number of nodes in the subtree of this node (itself included).
+		/// Shares the 32 bits of the balance, so the tree holds at most MAX_SIZE nodes
+		unsigned int count : 30;
 		/// @brief Node pointers for the children
 		Node* left, * right;
-		/// @brief Height of the subtree of that node 
-		size_t height = 0;
 		/// @brief Default constructor that sets value
 		Node(const T& value, Node* left = nullptr, Node* right = nullptr)
-			: value(value), left(left), right(right) {}
+			: value(value), balance(0), count(1), left(left), right(right) {}
 	};
+	/// @brief Maximum height that a tree can reach. AVL height is below 1.45*log2(n + 2),
+	/// so this covers MAX_SIZE nodes
+	static const int MAX_HEIGHT = 48;
+	/// @brief Number of searches that existsMany() keeps going at the same time
+	static const size_t LOOKUP_GROUP = 16;
+	/// @brief Trees with less nodes are copied by one thread
+	static const size_t PARALLEL_COPY_MIN = 1 << 16;
+	/// @brief Levels of the top of the tree copied before the subtrees are given to threads (up to 16 threads)
+	static const int MAX_COPY_SPLIT = 4;
+	static_assert(alignof(Node) <= Alloc::ALIGNMENT, "Allocator alignment is too small for the nodes");
+	/// @brief Returns the number of nodes in a subtree, 0 for nullptr
+	static size_t countOf(const Node* node) noexcept { return node ? node->count : 0; }
 	//data
+	/// @brief Allocator that gives the memory for the nodes
+	Alloc alloc;
 	/// @brief Node pointer to the root
 	Node* root = nullptr;
 	/// @brief Number of nodes in the tree
@@ -32,14 +57,31 @@ private:
 	/// @param current Start node for the copying
 	/// @return Root of the new tree
 	Node* makeCopy(const Node* current);
+	/// @brief Method to copy the top levels of a tree and collect the subtrees under them
+	/// @param subtrees Filled with the roots of the not copied subtrees
+	/// @param links Filled with the links where the copies of the subtrees go
+	/// @param depth Levels to be copied
+	/// @return Root of the new tree
+	Node* copyTop(const Node* current, int depth, std::vector<const Node*>& subtrees, std::vector<Node**>& links);
+	/// @brief Method to copy a tree with cnt nodes. Big trees are copied by many threads,
+	/// each with its own allocator whose chunks are adopted after that
+	/// @return Root of the new tree
+	Node* copyTree(const Node* current, size_t cnt);
+	/// @brief Method to build a perfectly balanced tree from cnt sorted values
+	/// @param it Iterator to the first value. Moved after the used values
+	/// @param cnt Number of values to use
+	/// @param h Set to the height of the new tree
+	/// @return Root of the new tree
+	template <class It>
+	Node* buildBalanced(It& it, size_t cnt, int& h);
+	/// @brief Method to allocate and construct a node with given value
+	Node* createNode(const T& val);
+	/// @brief Method to destruct a node and give its memory back to the allocator
+	void destroyNode(Node* node) noexcept;
 	/// @brief Method to delete all nodes in a tree. Does not set size
 	/// @param node Starting node for the deletion
 	void deleteAll(Node* node) noexcept;
-	/// @brief Method to return the smallest element and change it's place with his right child
-	/// @param node Starting node for the search
-	/// @return Smallest node
-	Node* getMin(Node* node) const noexcept;
-	/// @brief Method to return the height of the tree
+	/// @brief Method to return the height of the tree. Goes down on the higher side of each node
 	/// @param node Starting node for the counting
 	/// @return Height
 	int height(const Node* node) const noexcept;
@@ -48,37 +90,49 @@ private:
 	/// @param node Starting node for the counting
 	/// @return Pointer to the node with such value or nullptr if there isn't such
 	Node* findNode(const T& val, Node* node) const noexcept;
-	/// @brief Method to insert a node with specific value
+	/// @brief Method to insert a node with specific value. Goes down once remembering the path
+	/// and then fixes the balances on the way up
 	/// @param val Value to be added
-	/// @param node Starting node for the adding
-	/// @return Pointer to the last used node
-	Node* insertNode(const T& val, Node* node);
-	/// @brief Method to remove a node with specific value
+	/// @return False if a node with such value already exists
+	bool insertNode(const T& val);
+	/// @brief Method to remove a node with specific value. Goes down once (including the search
+	/// for the successor) remembering the path and then fixes the balances on the way up
 	/// @param val Value to be removed
-	/// @param node Starting node for the adding
-	/// @return Pointer to the last used node
-	Node* deleteNode(const T& val, Node* node) noexcept;
-	/// @brief Method to balance the tree when inserting and deleting nodes
-	/// @param val Value that has been changed lastly
-	/// @param node Starting node for the balance
-	/// @return Pointer to the last rotated node
-	Node* balanceTree(const T& val, Node* node) noexcept;
+	/// @return False if there is no node with such value
+	bool deleteNode(const T& val) noexcept;
+	/// @brief Method to update balances and rotate nodes on a path after a node was added under it.
+	/// Stops as soon as a subtree keeps its old height
+	/// @param path Links from the root to the added node. path[depth] is the link to the added node
+	/// @param depth Number of nodes above the added one
+	void fixAfterInsert(Node** path[], int depth) noexcept;
+	/// @brief Method to update balances and rotate nodes on a path after a node was removed under it.
+	/// Stops as soon as a subtree keeps its old height
+	/// @param path Links from the root to the changed place. path[depth] is the link that lost a node
+	/// @param depth Number of nodes above the changed place
+	void fixAfterDelete(Node** path[], int depth) noexcept;
+	/// @brief Method to balance a node whose balance became 2 or -2 and to set the new balances
+	/// @param node Node to be balanced
+	/// @param balance The new (not yet stored) balance of the node
+	/// @return Pointer to the node that took its place
+	Node* balanceTree(Node* node, int balance) noexcept;
 	/// @brief Standart Right rotation for the specific node
 	Node* rightRotate(Node* node) noexcept;
 	/// @brief Standart Left rotation for the specific node
 	Node* leftRotate(Node* node) noexcept;
 public:
-	friend class AVLIterator<T>;
+	friend class AVLIterator<T, Alloc>;
+	/// @brief Maximum number of nodes, limited by the 30 bits of the subtree counts
+	static const size_t MAX_SIZE = (1u << 30) - 1;
 	//constructors and operators
 	/// @brief Standart constructor creating empty tree
 	AVLTree() = default;
-	/// @brief Copy constructor. Uses MakeCopy()
+	/// @brief Copy constructor. Copies the structure (balances and counts too) in O(n). Uses copyTree()
 	/// @param other Tree to be copied
 	AVLTree(const AVLTree& other);
 	/// @brief Move constructor.
 	/// @param other Tree to be moved. Moved object will be deleted
 	AVLTree(AVLTree&& other) noexcept;
-	/// @brief Copy operator. Uses MakeCopy()
+	/// @brief Copy operator. Uses copyTree()
 	/// @param other Tree to be copied
 	AVLTree& operator=(const AVLTree& other);
 	/// @brief Move operator.
@@ -89,232 +143,373 @@ public:
 	//public methods
 	/// @brief Returns the number of nodes in the tree
 	size_t getSize() const noexcept;
-	/// @brief Inserts element through insertNode() method with specific key. Returns if operation was successful
+	/// @brief Inserts element through insertNode() method with specific key. Returns if operation was successful.
+	/// Fails when the tree already has MAX_SIZE nodes
 	bool insert(const T& key) noexcept;
 	/// @brief Removes element through deleteNode() method with specific key. Returns if operation was successful
 	bool remove(const T& key) noexcept;
 	/// @brief Returns if a node with such key exists. Uses findNode()
 	bool exists(const T& key) const noexcept;
+	/// @brief Checks many keys at once. Keeps LOOKUP_GROUP searches going and moves each one step
+	/// in turn after prefetching its next node, so the memory loads of different keys overlap
+	/// @param keys Keys to be searched
+	/// @param n Number of keys
+	/// @param out Set to exists(keys[i]) for each i
+	void existsMany(const T* keys, size_t n, bool* out) const noexcept;
+	/// @brief Replaces the data with the values in [first, last) in O(n).
+	/// The values have to be in strictly ascending order, the tree is built perfectly balanced
+	/// @return False (and nothing is changed) if the values are not strictly ascending or are more than MAX_SIZE
+	template <class It>
+	bool buildFromSorted(It first, It last);
+	/// @brief Returns the number of values less than key in O(log n)
+	size_t rank(const T& key) const noexcept;
+	/// @brief Returns pointer to the k-th smallest value (counting from 0) in O(log n).
+	/// nullptr if k is not less than the size
+	const T* select(size_t k) const noexcept;
+	/// @brief Returns the number of values in [lo, hi) in O(log n)
+	size_t countInRange(const T& lo, const T& hi) const noexcept;
+	/// @brief Returns pointer to the smallest value not less than key. nullptr if there is none
+	const T* lowerBound(const T& key) const noexcept;
+	/// @brief Returns pointer to the smallest value greater than key. nullptr if there is none
+	const T* upperBound(const T& key) const noexcept;
+	/// @brief Calls f(value) for every value in [lo, hi) in ascending order.
+	/// Walks in order only the nodes on the borders of the range and the ones inside it
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const;
 	/// @brief Returns tree height
 	size_t getHeight() const noexcept;
-	/// @brief Deleted all nodes and sets size to 0
+	/// @brief Deleted all nodes and sets size to 0. With a bulk releasing allocator
+	/// the memory is freed by chunks instead of node by node
 	void clearData() noexcept;
 	//iteration
-	/// @brief Returns iterator to the start (root) of the tree
-	AVLIterator<T> begin() const noexcept;
+	/// @brief Returns iterator to the start (smallest value) of the tree
+	AVLIterator<T, Alloc> begin() const noexcept;
 	/// @brief Returns iterator to the end (nullptr) of the tree
-	AVLIterator<T> end() const noexcept;
+	AVLIterator<T, Alloc> end() const noexcept;
 	/// @brief Returns the memory used by the structure in bytes
 	size_t getBytesUsed() const noexcept;
 	/// @brief Returns height of left side minus height of right
 	inline short getBalance(Node* node) const noexcept;
 };
 
-/// @brief AVL Tree iterator using left-parent-right traversal
-template <class T>
+/// @brief AVL Tree iterator using left-parent-right traversal (ascending order).
+/// Keeps the path in a fixed stack inside the iterator, so moving never allocates
+template <class T, class Alloc>
 class AVLIterator {
 private:
 	//data
-	/// @brief Stack of nodes to keep the next node in the order
-	std::stack<typename AVLTree<T>::Node*> nodes;
+	/// @brief Nodes whose left side is visited and they are not. The top is the current node
+	typename AVLTree<T, Alloc>::Node* nodes[AVLTree<T, Alloc>::MAX_HEIGHT];
+	/// @brief Number of nodes in the stack
+	int top = 0;
 	//methods
-	/// @brief Constructor that pushes the given node as root of the traversal
-	AVLIterator(typename AVLTree<T>::Node* firstNode) noexcept;
+	/// @brief Constructor that starts from the smallest node under the given one
+	AVLIterator(typename AVLTree<T, Alloc>::Node* firstNode) noexcept;
+	/// @brief Pushes a node and all nodes on its left side
+	void pushLeft(typename AVLTree<T, Alloc>::Node* node) noexcept;
 public:
-	friend class AVLTree<T>;
+	friend class AVLTree<T, Alloc>;
 	//methods
 	/// @brief Operator to move the stack to the next node in the order.
-	AVLIterator  operator++();
+	AVLIterator& operator++() noexcept;
 	/// @brief Operator to get the next Node in the order
-	const typename AVLTree<T>::Node* operator*() const;
+	const typename AVLTree<T, Alloc>::Node* operator*() const;
 	/// @brief Operator to check if two Iterators are the same
-	bool operator==(const AVLIterator<T>& other) const noexcept;
+	bool operator==(const AVLIterator<T, Alloc>& other) const noexcept;
 	/// @brief Operator to check if two Iterators are not the same
-	bool operator!=(const AVLIterator<T>& other) const noexcept;
+	bool operator!=(const AVLIterator<T, Alloc>& other) const noexcept;
 
 };
 
 //impl
 
-template<class T>
-inline short AVLTree<T>::getBalance(Node* node) const noexcept
+template<class T, class Alloc>
+inline short AVLTree<T, Alloc>::getBalance(Node* node) const noexcept
 {
-	return node ? height(node->left) - height(node->right) : 0;
+	return node ? node->balance : 0;
 }
 
-template<class T>
-bool AVLTree<T>::exists(const T& key) const noexcept
+template<class T, class Alloc>
+bool AVLTree<T, Alloc>::exists(const T& key) const noexcept
 {
 	return findNode(key, root) != nullptr;
 }
 
-template<class T>
-void AVLTree<T>::clearData() noexcept
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::existsMany(const T* keys, size_t n, bool* out) const noexcept
 {
-	deleteAll(root);
+	/// @brief State of one search: the node to be compared next and the key index
+	struct Probe {
+		const AVLTree<T, Alloc>::Node* node;
+		size_t idx;
+	};
+	Probe probes[LOOKUP_GROUP];
+	size_t active = 0, next = 0;
+	while (active < LOOKUP_GROUP && next < n) {
+		probes[active++] = { root, next++ };
+	}
+	prefetchRead(root);
+	while (active) {
+		for (size_t p = 0; p < active;) {
+			Probe& probe = probes[p];
+			const AVLTree<T, Alloc>::Node* node = probe.node;
+			const T& key = keys[probe.idx];
+			if (node && key < node->value) node = node->left;
+			else if (node && node->value < key) node = node->right;
+			else {
+				//found or reached nullptr, the place goes to the next key
+				out[probe.idx] = node != nullptr;
+				if (next < n) {
+					probe = { root, next++ };
+					p++;
+				}
+				else probe = probes[--active];
+				continue;
+			}
+			prefetchRead(node);
+			probe.node = node;
+			p++;
+		}
+	}
+}
+
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::clearData() noexcept
+{
+	if (!Alloc::BULK_RELEASE || !std::is_trivially_destructible<T>::value) {
+		deleteAll(root);
+	}
+	alloc.release();
 	root = nullptr;
 	size = 0;
 }
 
-template<class T>
-AVLIterator<T> AVLTree<T>::begin() const noexcept
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::createNode(const T& val)
 {
-	return AVLIterator<T>(root);
+	void* block = alloc.allocate(sizeof(Node));//may throw
+	try {
+		return new (block) Node(val);
+	}
+	catch (...) {
+		alloc.deallocate(block, sizeof(Node));
+		throw;
+	}
 }
 
-template<class T>
-AVLIterator<T> AVLTree<T>::end() const noexcept
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::destroyNode(AVLTree<T, Alloc>::Node* node) noexcept
 {
-	return AVLIterator<T>(nullptr);
+	node->~Node();
+	alloc.deallocate(node, sizeof(Node));
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::leftRotate(AVLTree<T>::Node* node) noexcept
+template<class T, class Alloc>
+AVLIterator<T, Alloc> AVLTree<T, Alloc>::begin() const noexcept
+{
+	return AVLIterator<T, Alloc>(root);
+}
+
+template<class T, class Alloc>
+AVLIterator<T, Alloc> AVLTree<T, Alloc>::end() const noexcept
+{
+	return AVLIterator<T, Alloc>(nullptr);
+}
+
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::leftRotate(AVLTree<T, Alloc>::Node* node) noexcept
 {
 	if (!node || !node->right) return node;
-	AVLTree<T>::Node* rightNode = node->right;
-	AVLTree<T>::Node* farLeft = rightNode->left;
+	AVLTree<T, Alloc>::Node* rightNode = node->right;
+	AVLTree<T, Alloc>::Node* farLeft = rightNode->left;
 	rightNode->left = node;
 	node->right = farLeft;
-	node->height = 1 + std::max(height(node->left), height(node->right));
-	rightNode->height = 1 + std::max(height(rightNode->left), height(rightNode->right));
+	rightNode->count = node->count;
+	node->count = countOf(node->left) + countOf(farLeft) + 1;
 	return rightNode;
 }
 
 
-template<class T>
-size_t AVLTree<T>::getBytesUsed() const noexcept
+template<class T, class Alloc>
+size_t AVLTree<T, Alloc>::getBytesUsed() const noexcept
 {
-	return size * sizeof(Node) + sizeof(AVLTree<T>);
+	return alloc.getBytesUsed() + sizeof(AVLTree<T, Alloc>);
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::balanceTree(const T& val, AVLTree<T>::Node* node) noexcept
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::balanceTree(AVLTree<T, Alloc>::Node* node, int balance) noexcept
 {
-	if (!node) return nullptr;
-	int bLeft = getBalance(node->left);
-	int bRight = getBalance(node->right);
-	int balance = getBalance(node);
-	if (balance > 1 && bLeft >= 0) {
-		return rightRotate(node);// Left Left Case
-	}
-	if (balance < -1 && bRight <= 0) {
-		return leftRotate(node);// Right Right Case
-	}
-	if (balance > 1 && bLeft < 0) {
-		node->left = leftRotate(node->left);// Left Right Case
+	if (balance > 1) {
+		AVLTree<T, Alloc>::Node* leftNode = node->left;
+		if (leftNode->balance >= 0) {// Left Left Case
+			//balance 0 on the left child happens only after deletion
+			node->balance = leftNode->balance == 0 ? 1 : 0;
+			leftNode->balance = leftNode->balance == 0 ? -1 : 0;
+			return rightRotate(node);
+		}
+		// Left Right Case
+		AVLTree<T, Alloc>::Node* middle = leftNode->right;
+		node->balance = middle->balance > 0 ? -1 : 0;
+		leftNode->balance = middle->balance < 0 ? 1 : 0;
+		middle->balance = 0;
+		node->left = leftRotate(leftNode);
 		return rightRotate(node);
 	}
-	if (balance < -1 && bLeft > 0) {
-		node->right = rightRotate(node->right);// Right Left Case
+	if (balance < -1) {
+		AVLTree<T, Alloc>::Node* rightNode = node->right;
+		if (rightNode->balance <= 0) {// Right Right Case
+			node->balance = rightNode->balance == 0 ? -1 : 0;
+			rightNode->balance = rightNode->balance == 0 ? 1 : 0;
+			return leftRotate(node);
+		}
+		// Right Left Case
+		AVLTree<T, Alloc>::Node* middle = rightNode->left;
+		node->balance = middle->balance < 0 ? 1 : 0;
+		rightNode->balance = middle->balance > 0 ? -1 : 0;
+		middle->balance = 0;
+		node->right = rightRotate(rightNode);
 		return leftRotate(node);
 	}
+	node->balance = balance;
 	return node;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::rightRotate(AVLTree<T>::Node* node) noexcept
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::rightRotate(AVLTree<T, Alloc>::Node* node) noexcept
 {
 	if (!node || !node->left) return node;
-	AVLTree<T>::Node* leftNode = node->left;
-	AVLTree<T>::Node* farRight = leftNode->right;
+	AVLTree<T, Alloc>::Node* leftNode = node->left;
+	AVLTree<T, Alloc>::Node* farRight = leftNode->right;
 	leftNode->right = node;
 	node->left = farRight;
-	
-	node->height = std::max(height(node->left), height(node->right));
-	leftNode->height = std::max(height(leftNode->left), height(leftNode->right));
+	leftNode->count = node->count;
+	node->count = countOf(farRight) + countOf(node->right) + 1;
 	return leftNode;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::insertNode(const T& val, AVLTree<T>::Node* node)
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::fixAfterInsert(AVLTree<T, Alloc>::Node** path[], int depth) noexcept
 {
-	if (node == nullptr) {
-		return new Node(val);
-	}
-	if (val < node->value) {
-		node->left = insertNode(val, node->left);
-	}
-	else if (val > node->value) {
-		node->right = insertNode(val, node->right);
-	}
-	else {//equal not permitted
-		throw std::logic_error("Node already exists");
+	for (int i = depth - 1; i >= 0; i--) {
+		AVLTree<T, Alloc>::Node* node = *path[i];
+		int balance = node->balance + (path[i + 1] == &node->left ? 1 : -1);
+		if (balance == 0) {//the shorter side grew, height is the same
+			node->balance = 0;
+			return;
+		}
+		if (balance == 1 || balance == -1) {//height grew, continue up
+			node->balance = balance;
+			continue;
+		}
+		//rotation brings the subtree back to its old height
+		*path[i] = balanceTree(node, balance); //!balancing part!
+		return;
 	}
-	node->height = 1 + std::max(height(node->left), height(node->right));
-
-	if (std::abs(height(node->left) - height(node->right)) > 1)
-		return balanceTree(val, node); //!balancing part!
-	else return node;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::deleteNode(const T& val, AVLTree<T>::Node* node) noexcept {
-	if (!node)
-		return node;
-	if (val < node->value) {
-		node->left = deleteNode(val, node->left);
-	}
-	else if (val > node->value) {
-		node->right = deleteNode(val, node->right);
-	}
-	else
-	{
-		//one child cases
-		if (!node->left || !node->right)
-		{
-			AVLTree<T>::Node* temp = node->left ? node->left : node->right;
-			if (!temp)
-			{
-				temp = node;
-				node = nullptr;
-			}
-			else
-			{
-				*node = *temp; //copy values
-			}
-			if (temp == root) {
-				delete root;
-				root = nullptr;
-			}
-			else {
-				delete temp;
-			}
-			temp = nullptr;
-			--size;
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::fixAfterDelete(AVLTree<T, Alloc>::Node** path[], int depth) noexcept
+{
+	for (int i = depth - 1; i >= 0; i--) {
+		AVLTree<T, Alloc>::Node* node = *path[i];
+		int balance = node->balance + (path[i + 1] == &node->left ? -1 : 1);
+		if (balance == 1 || balance == -1) {//the higher side is the same, height is the same
+			node->balance = balance;
+			return;
 		}
-		else
-		{
-			AVLTree<T>::Node* temp = getMin(node->right);
-			node->value = temp->value;
-			node->right = deleteNode(temp->value, node->right);
+		if (balance == 0) {//height shrank, continue up
+			node->balance = 0;
+			continue;
 		}
+		node = balanceTree(node, balance); //!balancing part!
+		*path[i] = node;
+		//after rotation the height is the same only if the new top is not balanced
+		if (node->balance != 0) return;
 	}
-	if (!node)
-		return node;
-	//height update
-	node->height = 1 + std::max(height(node->left), height(node->right));
-
-	//return 
-	if (std::abs(height(node->left) - height(node->right)) > 1)
-		return balanceTree(val, node); //!balancing part!
-	else return node;
+}
 
+template<class T, class Alloc>
+bool AVLTree<T, Alloc>::insertNode(const T& val)
+{
+	AVLTree<T, Alloc>::Node** path[MAX_HEIGHT + 1];
+	int depth = 0;
+	AVLTree<T, Alloc>::Node** link = &root;
+	while (*link) {
+		path[depth++] = link;
+		if (val < (*link)->value) {
+			link = &(*link)->left;
+		}
+		else if ((*link)->value < val) {
+			link = &(*link)->right;
+		}
+		else {//equal not permitted
+			return false;
+		}
+	}
+	*link = createNode(val);//may throw, nothing is changed yet
+	path[depth] = link;
+	for (int i = 0; i < depth; i++) {
+		++(*path[i])->count;
+	}
+	fixAfterInsert(path, depth);
+	return true;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::getMin(typename AVLTree<T>::Node* node) const noexcept {
-	if (node->left) {
-		return getMin(node->left);
+template<class T, class Alloc>
+bool AVLTree<T, Alloc>::deleteNode(const T& val) noexcept {
+	AVLTree<T, Alloc>::Node** path[MAX_HEIGHT + 1];
+	int depth = 0;
+	AVLTree<T, Alloc>::Node** link = &root;
+	while (*link) {
+		if (val < (*link)->value) {
+			path[depth++] = link;
+			link = &(*link)->left;
+		}
+		else if ((*link)->value < val) {
+			path[depth++] = link;
+			link = &(*link)->right;
+		}
+		else break;
 	}
-	AVLTree<T>::Node* lastRoot = node;
-	node = node->right;
-	return lastRoot;
+	AVLTree<T, Alloc>::Node* target = *link;
+	if (!target) return false;
 
+	if (!target->left || !target->right) {
+		//one child cases
+		*link = target->left ? target->left : target->right;
+		path[depth] = link;
+	}
+	else {
+		//continue down to the smallest node on the right and put it in the target's place
+		int targetDepth = depth;
+		path[depth++] = link;
+		AVLTree<T, Alloc>::Node** succLink = &target->right;
+		while ((*succLink)->left) {
+			path[depth++] = succLink;
+			succLink = &(*succLink)->left;
+		}
+		path[depth] = succLink;
+		AVLTree<T, Alloc>::Node* successor = *succLink;
+		*succLink = successor->right;
+		successor->left = target->left;
+		successor->right = target->right;
+		successor->balance = target->balance;
+		successor->count = target->count;
+		*link = successor;
+		//the link under the target is now owned by the successor
+		path[targetDepth + 1] = &successor->right;
+	}
+	for (int i = 0; i < depth; i++) {
+		--(*path[i])->count;
+	}
+	destroyNode(target);
+	--size;
+	fixAfterDelete(path, depth);
+	return true;
 }
 
-template<class T>
-void AVLTree<T>::deleteAll(AVLTree<T>::Node* node) noexcept
+template<class T, class Alloc>
+void AVLTree<T, Alloc>::deleteAll(AVLTree<T, Alloc>::Node* node) noexcept
 {
 	if (!node) return; //for when root is nullptr
 	if (node->left) {
@@ -323,38 +518,43 @@ void AVLTree<T>::deleteAll(AVLTree<T>::Node* node) noexcept
 	if (node->right) {
 		deleteAll(node->right);
 	}
-	delete node;
+	destroyNode(node);
 }
 
-template<class T>
-int AVLTree<T>::height(const AVLTree<T>::Node* node) const noexcept
+template<class T, class Alloc>
+int AVLTree<T, Alloc>::height(const AVLTree<T, Alloc>::Node* node) const noexcept
 {
-	/*if (!node) return 0;
-	int leftH = height(node->left);
-	int rightH = height(node->right);
-	return 1 + (leftH > rightH ? leftH : rightH);*/
-	if (!node) return 0;
-	return node->height;
+	int h = 0;
+	while (node) {
+		++h;
+		node = node->balance < 0 ? node->right : node->left;
+	}
+	return h;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::findNode(const T& val, AVLTree<T>::Node* node) const noexcept {
-	if (!node) return nullptr;
-	if (node->value == val) return node;
-	return val < node->value ? findNode(val, node->left) : findNode(val, node->right);
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::findNode(const T& val, AVLTree<T, Alloc>::Node* node) const noexcept {
+	while (node) {
+		if (val < node->value) node = node->left;
+		else if (node->value < val) node = node->right;
+		else return node;
+	}
+	return nullptr;
 }
 
-template<class T>
-typename AVLTree<T>::Node* AVLTree<T>::makeCopy(const AVLTree<T>::Node* current)
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::makeCopy(const AVLTree<T, Alloc>::Node* current)
 {
 	if (!current) return nullptr;
-	AVLTree<T>::Node* node = nullptr;
-	node = new Node(current->value);//may throw
+	AVLTree<T, Alloc>::Node* node = nullptr;
+	node = createNode(current->value);//may throw
+	node->balance = current->balance;
+	node->count = current->count;
 	try {
 		node->left = makeCopy(current->left);
 	}
 	catch (...) {
-		delete node;
+		destroyNode(node);
 		throw;
 	}
 	try {
@@ -362,33 +562,161 @@ typename AVLTree<T>::Node* AVLTree<T>::makeCopy(const AVLTree<T>::Node* current)
 	}
 	catch (...) {
 		deleteAll(node->left);
-		delete node;
+		destroyNode(node);
 		size = 0;
 		throw;
 	}
 	return node;
 }
 
-template<class T>
-AVLTree<T>::AVLTree<T>(const AVLTree<T>& other)
+template<class T, class Alloc>
+template <class It>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::buildBalanced(It& it, size_t cnt, int& h)
 {
-	root = makeCopy(other.root);
+	if (!cnt) {
+		h = 0;
+		return nullptr;
+	}
+	//left side gets the extra node, so it is never lower than the right one
+	size_t rightCnt = (cnt - 1) / 2;
+	int leftH, rightH;
+	AVLTree<T, Alloc>::Node* left = buildBalanced(it, cnt - 1 - rightCnt, leftH);
+	AVLTree<T, Alloc>::Node* node = nullptr;
+	try {
+		node = createNode(*it);//may throw
+	}
+	catch (...) {
+		deleteAll(left);
+		throw;
+	}
+	++it;
+	node->left = left;
+	try {
+		node->right = buildBalanced(it, rightCnt, rightH);
+	}
+	catch (...) {
+		deleteAll(node);
+		throw;
+	}
+	node->balance = leftH - rightH;
+	node->count = (unsigned int)cnt;
+	h = leftH + 1;
+	return node;
+}
+
+template<class T, class Alloc>
+template <class It>
+bool AVLTree<T, Alloc>::buildFromSorted(It first, It last)
+{
+	//counting pass that also checks the order, so nothing is changed for wrong input
+	size_t cnt = 0;
+	for (It prev = first, it = first; it != last; prev = it++) {
+		if (cnt && !(*prev < *it)) return false;
+		if (++cnt > MAX_SIZE) return false;
+	}
+	AVLTree<T, Alloc> built;
+	int h;
+	built.root = built.buildBalanced(first, cnt, h);//may throw
+	built.size = cnt;
+	*this = std::move(built);
+	return true;
+}
+
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::copyTop(const AVLTree<T, Alloc>::Node* current, int depth,
+	std::vector<const AVLTree<T, Alloc>::Node*>& subtrees, std::vector<AVLTree<T, Alloc>::Node**>& links)
+{
+	if (!current) return nullptr;
+	AVLTree<T, Alloc>::Node* node = createNode(current->value);//may throw
+	node->balance = current->balance;
+	node->count = current->count;
+	if (depth == 1) {
+		//vectors have enough capacity, nothing throws
+		subtrees.push_back(current->left);
+		links.push_back(&node->left);
+		subtrees.push_back(current->right);
+		links.push_back(&node->right);
+		return node;
+	}
+	try {
+		node->left = copyTop(current->left, depth - 1, subtrees, links);
+		node->right = copyTop(current->right, depth - 1, subtrees, links);
+	}
+	catch (...) {
+		deleteAll(node);
+		throw;
+	}
+	return node;
+}
+
+template<class T, class Alloc>
+typename AVLTree<T, Alloc>::Node* AVLTree<T, Alloc>::copyTree(const AVLTree<T, Alloc>::Node* current, size_t cnt)
+{
+	int depth = 0;
+	unsigned threads = std::thread::hardware_concurrency();
+	while (depth < MAX_COPY_SPLIT && (2u << depth) <= threads) depth++;
+	if (cnt < PARALLEL_COPY_MIN || depth == 0) return makeCopy(current);
+
+	std::vector<const AVLTree<T, Alloc>::Node*> subtrees;
+	std::vector<AVLTree<T, Alloc>::Node**> links;
+	subtrees.reserve(size_t(1) << depth);
+	links.reserve(size_t(1) << depth);
+	AVLTree<T, Alloc>::Node* top = copyTop(current, depth, subtrees, links);//may throw
+
+	//every subtree is copied in its own tree, so the threads do not share allocators
+	std::vector<AVLTree<T, Alloc>> parts(subtrees.size());
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(subtrees.size());
+	for (size_t i = 0; i < subtrees.size(); i++) {
+		auto job = [&parts, &subtrees, i]() { parts[i].root = parts[i].makeCopy(subtrees[i]); };
+		try {
+			tasks.push_back(std::async(std::launch::async, job));
+		}
+		catch (...) {//no thread, copy it on get()
+			tasks.push_back(std::async(std::launch::deferred, job));
+		}
+	}
+	std::exception_ptr error;
+	for (size_t i = 0; i < tasks.size(); i++) {
+		try {
+			tasks[i].get();
+		}
+		catch (...) {
+			if (!error) error = std::current_exception();
+		}
+		alloc.adopt(parts[i].alloc);
+		*links[i] = parts[i].root;
+		parts[i].root = nullptr;
+	}
+	if (error) {
+		deleteAll(top);
+		std::rethrow_exception(error);
+	}
+	return top;
+}
+
+template<class T, class Alloc>
+AVLTree<T, Alloc>::AVLTree<T, Alloc>(const AVLTree<T, Alloc>& other)
+{
+	root = copyTree(other.root, other.size);
+	size = other.size;
 	//if root=nullptr -> problem with allocation
 }
 
-template<class T>
-AVLTree<T>::AVLTree<T>(AVLTree<T>&& other) noexcept
-	:AVLTree<T>()
+template<class T, class Alloc>
+AVLTree<T, Alloc>::AVLTree<T, Alloc>(AVLTree<T, Alloc>&& other) noexcept
+	:AVLTree<T, Alloc>()
 {
 	std::swap(other.size, this->size);
 	std::swap(other.root, this->root);
+	alloc.swap(other.alloc);
 }
 
-template<class T>
-AVLTree<T>& AVLTree<T>::operator=(const AVLTree<T>& other)
+template<class T, class Alloc>
+AVLTree<T, Alloc>& AVLTree<T, Alloc>::operator=(const AVLTree<T, Alloc>& other)
 {
 	if (&other != this) {
-		AVLTree<T>::Node* newRoot = makeCopy(other.root);
+		AVLTree<T, Alloc>::Node* newRoot = copyTree(other.root, other.size);
 		deleteAll(root);
 		size = other.getSize();
 		root = newRoot;
@@ -396,96 +724,182 @@ AVLTree<T>& AVLTree<T>::operator=(const AVLTree<T>& other)
 	return *this;
 }
 
-template<class T>
-AVLTree<T>& AVLTree<T>::operator=(AVLTree<T>&& other) noexcept
+template<class T, class Alloc>
+AVLTree<T, Alloc>& AVLTree<T, Alloc>::operator=(AVLTree<T, Alloc>&& other) noexcept
 {
 
 	if (&other != this) {
-		deleteAll(root);
-		size = 0;
+		clearData();
 		std::swap(other.size, this->size);
 		std::swap(other.root, this->root);
+		alloc.swap(other.alloc);
 	}
 	return *this;
 }
 
-template<class T>
-AVLTree<T>::~AVLTree<T>() noexcept
+template<class T, class Alloc>
+AVLTree<T, Alloc>::~AVLTree<T, Alloc>() noexcept
 {
-	if (root) {
-		deleteAll(root);
-		size = 0;
-		root = nullptr;
-	}
+	clearData();
 }
 
-template<class T>
-size_t AVLTree<T>::getSize() const noexcept
+template<class T, class Alloc>
+size_t AVLTree<T, Alloc>::getSize() const noexcept
 {
 	return size;
 }
 
-template<class T>
-bool AVLTree<T>::remove(const T& key) noexcept
+template<class T, class Alloc>
+bool AVLTree<T, Alloc>::remove(const T& key) noexcept
 {
-	auto oldSize = size;
-	root = deleteNode(key, root);
-	return oldSize > size;
+	return deleteNode(key);
 }
 
-template<class T>
-bool AVLTree<T>::insert(const T& key) noexcept
+template<class T, class Alloc>
+bool AVLTree<T, Alloc>::insert(const T& key) noexcept
 {
-	try {
-		root = insertNode(key, root);
-		++size;
+	//repetitions are reported through the return value, no exception is thrown for them
+	if (size >= MAX_SIZE || !insertNode(key)) return false;
+	++size;
+	return true;
+}
+
+template<class T, class Alloc>
+size_t AVLTree<T, Alloc>::rank(const T& key) const noexcept
+{
+	size_t less = 0;
+	const AVLTree<T, Alloc>::Node* node = root;
+	while (node) {
+		if (node->value < key) {
+			less += countOf(node->left) + 1;
+			node = node->right;
+		}
+		else node = node->left;
 	}
-	catch (const std::logic_error&) { //repetition
-		return false;
+	return less;
+}
+
+template<class T, class Alloc>
+const T* AVLTree<T, Alloc>::select(size_t k) const noexcept
+{
+	if (k >= size) return nullptr;
+	const AVLTree<T, Alloc>::Node* node = root;
+	while (node) {
+		size_t leftCnt = countOf(node->left);
+		if (k < leftCnt) node = node->left;
+		else if (k > leftCnt) {
+			k -= leftCnt + 1;
+			node = node->right;
+		}
+		else return &node->value;
+	}
+	return nullptr;
+}
+
+template<class T, class Alloc>
+size_t AVLTree<T, Alloc>::countInRange(const T& lo, const T& hi) const noexcept
+{
+	if (!(lo < hi)) return 0;
+	return rank(hi) - rank(lo);
+}
+
+template<class T, class Alloc>
+const T* AVLTree<T, Alloc>::lowerBound(const T& key) const noexcept
+{
+	const AVLTree<T, Alloc>::Node* node = root;
+	const T* bound = nullptr;
+	while (node) {
+		if (node->value < key) node = node->right;
+		else {
+			bound = &node->value;
+			node = node->left;
+		}
+	}
+	return bound;
+}
+
+template<class T, class Alloc>
+const T* AVLTree<T, Alloc>::upperBound(const T& key) const noexcept
+{
+	const AVLTree<T, Alloc>::Node* node = root;
+	const T* bound = nullptr;
+	while (node) {
+		if (key < node->value) {
+			bound = &node->value;
+			node = node->left;
+		}
+		else node = node->right;
+	}
+	return bound;
+}
+
+template<class T, class Alloc>
+template <class F>
+void AVLTree<T, Alloc>::forEachInRange(const T& lo, const T& hi, F f) const
+{
+	//the stack keeps the nodes not less than lo whose left side is already pushed
+	const AVLTree<T, Alloc>::Node* stack[MAX_HEIGHT];
+	int top = 0;
+	const AVLTree<T, Alloc>::Node* node = root;
+	while (node) {
+		if (node->value < lo) node = node->right;
+		else {
+			stack[top++] = node;
+			node = node->left;
+		}
+	}
+	while (top) {
+		node = stack[--top];
+		if (!(node->value < hi)) return;
+		f(node->value);
+		//everything on the right is greater than lo
+		for (node = node->right; node; node = node->left) {
+			stack[top++] = node;
+		}
 	}
-	//memory allocation errors wont change the state of the tree 
-	return true;
 }
 
-template<class T>
-size_t AVLTree<T>::getHeight() const noexcept {
+template<class T, class Alloc>
+size_t AVLTree<T, Alloc>::getHeight() const noexcept {
 	return height(root);
 }
 
-template<class T>
-AVLIterator<T> AVLIterator<T>::operator++()
+template<class T, class Alloc>
+AVLIterator<T, Alloc>& AVLIterator<T, Alloc>::operator++() noexcept
 {
-	if (nodes.empty()) {
-		return AVLIterator<T>(nullptr);
+	if (top) {
+		//the left side and the node are visited, the next one is the smallest on the right
+		pushLeft(nodes[--top]->right);
 	}
-	typename AVLTree<T>::Node* node = nodes.top();
-	nodes.pop();
-	if (node->right) nodes.push(node->right);
-	if (node->left) nodes.push(node->left);
 	return *this;
 }
 
-template<class T>
-AVLIterator<T>::AVLIterator(typename AVLTree<T>::Node* firstNode) noexcept
+template<class T, class Alloc>
+AVLIterator<T, Alloc>::AVLIterator(typename AVLTree<T, Alloc>::Node* firstNode) noexcept
 {
-	if (!firstNode) return;
-	nodes.push(firstNode);
+	pushLeft(firstNode);
+}
 
+template<class T, class Alloc>
+void AVLIterator<T, Alloc>::pushLeft(typename AVLTree<T, Alloc>::Node* node) noexcept
+{
+	for (; node; node = node->left) {
+		nodes[top++] = node;
+	}
 }
 
-template<class T>
-const typename AVLTree<T>::Node* AVLIterator<T>::operator*() const
+template<class T, class Alloc>
+const typename AVLTree<T, Alloc>::Node* AVLIterator<T, Alloc>::operator*() const
 {
-	if (nodes.empty()) return nullptr;
-	return nodes.top();
+	return top ? nodes[top - 1] : nullptr;
 }
 
-template<class T>
-bool AVLIterator<T>::operator==(const AVLIterator<T>& other) const noexcept {
+template<class T, class Alloc>
+bool AVLIterator<T, Alloc>::operator==(const AVLIterator<T, Alloc>& other) const noexcept {
 	return operator*() == *other;
 }
 
-template<class T>
-bool AVLIterator<T>::operator!=(const AVLIterator<T>& other) const noexcept {
+template<class T, class Alloc>
+bool AVLIterator<T, Alloc>::operator!=(const AVLIterator<T, Alloc>& other) const noexcept {
 	return operator*() != *other;
 }
\ No newline at end of file
@@ -0,0 +1,821 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "T_NodeAllocator.h"
+#include "T_BlockSearch.h"
+
+template <class T, class Alloc = SlabAllocator<>>
+class BPlusIterator;
+
+/// @brief B+ tree with no repetitions rule. Every node is NODE_BYTES (a few cache lines): the leaves keep
+/// the sorted values and are linked for scans, the inner nodes keep only separators and children.
+/// A search loads one node per level and compares values that lie next to each other, instead of
+/// following one pointer per comparison as the AVL and the Skip List do.
+/// T has to be default constructible and assignable, as nodes keep arrays of values
+/// @tparam Alloc Node allocator policy (see T_NodeAllocator.h)
+template <class T, class Alloc = SlabAllocator<>>
+class BPlusTree {
+private:
+	/// @brief Bytes of a node: 4 cache lines of 64 bytes. Nodes keep at least 4 values for big T
+	static const size_t NODE_BYTES = 256;
+	/// @brief Number of values that a leaf holds
+	static const size_t LEAF_CAP = (NODE_BYTES - 2 * sizeof(void*)) / sizeof(T) > 4 ? (NODE_BYTES - 2 * sizeof(void*)) / sizeof(T) : 4;
+	/// @brief Number of separators that an inner node holds. It has one child more
+	static const size_t INNER_CAP = (NODE_BYTES - 2 * sizeof(void*)) / (sizeof(T) + sizeof(void*)) > 4 ?
+		(NODE_BYTES - 2 * sizeof(void*)) / (sizeof(T) + sizeof(void*)) : 4;
+	/// @brief Least values in a leaf and separators in an inner node, except for the root
+	static const size_t LEAF_MIN = LEAF_CAP / 2;
+	static const size_t INNER_MIN = INNER_CAP / 2;
+	/// @brief Maximum height. Inner nodes below the root have at least 3 children
+	static const int MAX_HEIGHT = 48;
+	/// @brief Part that all nodes start with
+	struct Node {
+		/// @brief Number of values in a leaf, number of separators in an inner node
+		unsigned short count;
+		/// @brief True for the leaves
+		bool leaf;
+		Node(bool leaf) : count(0), leaf(leaf) {}
+	};
+	/// @brief Node with values in ascending order
+	struct Leaf : Node {
+		/// @brief Leaf with the next values. nullptr for the last one
+		Leaf* next = nullptr;
+		T values[LEAF_CAP];
+		Leaf() : Node(true) {}
+	};
+	/// @brief Node with separators: all values under children[i] are less than keys[i]
+	/// and all values under children[i + 1] are not less than it
+	struct Inner : Node {
+		T keys[INNER_CAP];
+		Node* children[INNER_CAP + 1];
+		Inner() : Node(false) {}
+	};
+	static_assert(alignof(Leaf) <= Alloc::ALIGNMENT && alignof(Inner) <= Alloc::ALIGNMENT, "Allocator alignment is too small for the nodes");
+	//data
+	/// @brief Allocator that gives the memory for the nodes
+	Alloc alloc;
+	/// @brief Pointer to the root node. nullptr for an empty tree
+	Node* root = nullptr;
+	/// @brief Number of values in the tree
+	size_t size = 0;
+	/// @brief Number of levels. 0 for an empty tree, 1 when the root is a leaf
+	size_t height = 0;
+	//private methods
+
+	/// @brief Returns the number of keys less than val. Integral keys are compared many at once (see T_BlockSearch.h)
+	static size_t lowerIndex(const T* keys, size_t cnt, const T& val) noexcept;
+	/// @brief Returns the number of keys not greater than val. Integral keys are compared many at once
+	static size_t upperIndex(const T* keys, size_t cnt, const T& val) noexcept;
+	/// @brief Method to allocate and construct an empty leaf
+	Leaf* createLeaf();
+	/// @brief Method to allocate and construct an empty inner node
+	Inner* createInner();
+	/// @brief Method to destruct a node and give its memory back to the allocator
+	void destroyNode(Node* node) noexcept;
+	/// @brief Method to delete a node and all nodes under it
+	void deleteAll(Node* node) noexcept;
+	/// @brief Method to copy a node and all nodes under it
+	/// @param prevLeaf Last copied leaf. The copied leaves are linked after it and it is moved to the last one
+	/// @return The copy
+	Node* copyNode(const Node* node, Leaf*& prevLeaf);
+	/// @brief Method to build the tree (must be empty) from cnt sorted values. Leaves and inner nodes
+	/// are filled evenly, so all of them are at least half full
+	template <class It>
+	void buildLevels(It first, size_t cnt);
+	/// @brief Returns the leaf where val is or would be
+	Leaf* findLeaf(const T& val) const noexcept;
+	/// @brief Returns the leftmost leaf. nullptr for an empty tree
+	Leaf* firstLeaf() const noexcept;
+	/// @brief Method to insert a value. Goes down once remembering the path and splits the full nodes on
+	/// the way up. All new nodes are allocated before anything is changed
+	/// @return False if the value already exists
+	bool insertValue(const T& val);
+	/// @brief Method to remove a value. Goes down once remembering the path and fixes the nodes that have
+	/// less than the least values on the way up, by taking one from a sibling or merging with it
+	/// @return False if there is no such value
+	bool removeValue(const T& val) noexcept;
+	/// @brief Method to fix a leaf with LEAF_MIN - 1 values
+	/// @param parent Parent of the leaf
+	/// @param i Index of the leaf in the children of the parent
+	void fixLeaf(Leaf* leaf, Inner* parent, size_t i) noexcept;
+	/// @brief Method to fix an inner node with INNER_MIN - 1 separators
+	/// @param parent Parent of the node
+	/// @param i Index of the node in the children of the parent
+	void fixInner(Inner* node, Inner* parent, size_t i) noexcept;
+	/// @brief Method to remove keys[k] and children[k + 1] from an inner node
+	static void eraseChild(Inner* node, size_t k) noexcept;
+public:
+	friend class BPlusIterator<T, Alloc>;
+	//constructors and operators
+	/// @brief Standart constructor creating empty tree
+	BPlusTree() = default;
+	/// @brief Copy constructor. Copies the nodes as they are in O(n). Uses copyNode()
+	/// @param other Tree to be copied
+	BPlusTree(const BPlusTree& other);
+	/// @brief Move constructor.
+	/// @param other Tree to be moved. Moved object will be empty
+	BPlusTree(BPlusTree&& other) noexcept;
+	/// @brief Copy operator. Nothing is changed if the copy fails
+	/// @param other Tree to be copied
+	BPlusTree& operator=(const BPlusTree& other);
+	/// @brief Move operator.
+	/// @param other Tree to be moved. Moved object will be empty
+	BPlusTree& operator=(BPlusTree&& other) noexcept;
+	/// @brief Destructor. Uses clearData()
+	~BPlusTree() noexcept;
+	//public methods
+	/// @brief Returns the number of values in the tree
+	size_t getSize() const noexcept;
+	/// @brief Inserts a value through insertValue(). Returns if operation was successful.
+	/// May throw std::bad_alloc, then the tree is not changed
+	bool insert(const T& key);
+	/// @brief Removes a value through removeValue(). Returns if operation was successful
+	bool remove(const T& key) noexcept;
+	/// @brief Returns if such value exists
+	bool exists(const T& key) const noexcept;
+	/// @brief Replaces the data with the values in [first, last) in O(n).
+	/// The values have to be in strictly ascending order, the nodes are filled evenly bottom-up
+	/// @return False (and nothing is changed) if the values are not strictly ascending
+	template <class It>
+	bool buildFromSorted(It first, It last);
+	/// @brief Returns pointer to the smallest value not less than key. nullptr if there is none
+	const T* lowerBound(const T& key) const noexcept;
+	/// @brief Returns pointer to the smallest value greater than key. nullptr if there is none
+	const T* upperBound(const T& key) const noexcept;
+	/// @brief Calls f(value) for every value in [lo, hi) in ascending order.
+	/// Goes down to lo once and then walks the linked leaves
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const;
+	/// @brief Returns the number of levels
+	size_t getHeight() const noexcept;
+	/// @brief Deletes all nodes and sets size to 0. With a bulk releasing allocator
+	/// the memory is freed by chunks instead of node by node
+	void clearData() noexcept;
+	//iteration
+	/// @brief Returns iterator to the smallest value
+	BPlusIterator<T, Alloc> begin() const noexcept;
+	/// @brief Returns iterator to the end (nullptr)
+	BPlusIterator<T, Alloc> end() const noexcept;
+	/// @brief Returns the memory used by the structure in bytes
+	size_t getBytesUsed() const noexcept;
+};
+
+/// @brief B+ tree iterator that walks the linked leaves (ascending order).
+/// Unlike the other iterators it gives pointers to the values, as the nodes hold many of them
+template <class T, class Alloc>
+class BPlusIterator {
+private:
+	//data
+	/// @brief Current leaf. nullptr at the end
+	const typename BPlusTree<T, Alloc>::Leaf* leaf;
+	/// @brief Index of the current value in the leaf
+	size_t pos;
+	//methods
+	/// @brief Constructor that starts from the first value of a leaf
+	BPlusIterator(const typename BPlusTree<T, Alloc>::Leaf* leaf) noexcept;
+public:
+	friend class BPlusTree<T, Alloc>;
+	//methods
+	/// @brief Operator to move to the next value in the order.
+	BPlusIterator& operator++() noexcept;
+	/// @brief Operator to get pointer to the current value. nullptr at the end
+	const T* operator*() const noexcept;
+	/// @brief Operator to check if two Iterators are the same
+	bool operator==(const BPlusIterator<T, Alloc>& other) const noexcept;
+	/// @brief Operator to check if two Iterators are not the same
+	bool operator!=(const BPlusIterator<T, Alloc>& other) const noexcept;
+};
+
+//impl
+
+template<class T, class Alloc>
+size_t BPlusTree<T, Alloc>::lowerIndex(const T* keys, size_t cnt, const T& val) noexcept
+{
+	return BlockSearch<T>::lowerIndex(keys, cnt, val);
+}
+
+template<class T, class Alloc>
+size_t BPlusTree<T, Alloc>::upperIndex(const T* keys, size_t cnt, const T& val) noexcept
+{
+	return BlockSearch<T>::upperIndex(keys, cnt, val);
+}
+
+template<class T, class Alloc>
+typename BPlusTree<T, Alloc>::Leaf* BPlusTree<T, Alloc>::createLeaf()
+{
+	void* block = alloc.allocate(sizeof(Leaf));//may throw
+	try {
+		return new (block) Leaf();
+	}
+	catch (...) {
+		alloc.deallocate(block, sizeof(Leaf));
+		throw;
+	}
+}
+
+template<class T, class Alloc>
+typename BPlusTree<T, Alloc>::Inner* BPlusTree<T, Alloc>::createInner()
+{
+	void* block = alloc.allocate(sizeof(Inner));//may throw
+	try {
+		return new (block) Inner();
+	}
+	catch (...) {
+		alloc.deallocate(block, sizeof(Inner));
+		throw;
+	}
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::destroyNode(Node* node) noexcept
+{
+	if (node->leaf) {
+		static_cast<Leaf*>(node)->~Leaf();
+		alloc.deallocate(node, sizeof(Leaf));
+	}
+	else {
+		static_cast<Inner*>(node)->~Inner();
+		alloc.deallocate(node, sizeof(Inner));
+	}
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::deleteAll(Node* node) noexcept
+{
+	if (!node) return; //for when root is nullptr
+	if (!node->leaf) {
+		Inner* inner = static_cast<Inner*>(node);
+		for (size_t i = 0; i <= inner->count; i++) {
+			deleteAll(inner->children[i]);
+		}
+	}
+	destroyNode(node);
+}
+
+template<class T, class Alloc>
+typename BPlusTree<T, Alloc>::Node* BPlusTree<T, Alloc>::copyNode(const Node* node, Leaf*& prevLeaf)
+{
+	if (node->leaf) {
+		const Leaf* from = static_cast<const Leaf*>(node);
+		Leaf* leaf = createLeaf();//may throw
+		try {
+			std::copy(from->values, from->values + from->count, leaf->values);
+		}
+		catch (...) {
+			destroyNode(leaf);
+			throw;
+		}
+		leaf->count = from->count;
+		if (prevLeaf) prevLeaf->next = leaf;
+		prevLeaf = leaf;
+		return leaf;
+	}
+	const Inner* from = static_cast<const Inner*>(node);
+	Inner* inner = createInner();//may throw
+	size_t done = 0;
+	try {
+		std::copy(from->keys, from->keys + from->count, inner->keys);
+		for (; done <= from->count; done++) {
+			inner->children[done] = copyNode(from->children[done], prevLeaf);
+		}
+	}
+	catch (...) {
+		for (size_t i = 0; i < done; i++) {
+			deleteAll(inner->children[i]);
+		}
+		destroyNode(inner);
+		throw;
+	}
+	inner->count = from->count;
+	return inner;
+}
+
+template<class T, class Alloc>
+template <class It>
+void BPlusTree<T, Alloc>::buildLevels(It first, size_t cnt)
+{
+	//level holds the nodes of the current level and their smallest values. The ones from used on
+	//are not under a node of upper yet, so they are deleted alone if an allocation fails
+	std::vector<Node*> level, upper;
+	std::vector<T> mins, upperMins;
+	size_t used = 0;
+	try {
+		size_t leafCnt = (cnt + LEAF_CAP - 1) / LEAF_CAP;
+		level.reserve(leafCnt);
+		mins.reserve(leafCnt);
+		Leaf* prev = nullptr;
+		for (size_t l = 0; l < leafCnt; l++) {
+			Leaf* leaf = createLeaf();
+			level.push_back(leaf);
+			if (prev) prev->next = leaf;
+			prev = leaf;
+			//the first leaves get one value more when they can not all have the same count
+			size_t n = cnt / leafCnt + (l < cnt % leafCnt ? 1 : 0);
+			for (; leaf->count < n; ++first) {
+				leaf->values[leaf->count++] = *first;
+			}
+			mins.push_back(leaf->values[0]);
+		}
+		height = 1;
+		while (level.size() > 1) {
+			size_t innerCnt = (level.size() + INNER_CAP) / (INNER_CAP + 1);
+			upper.reserve(innerCnt);
+			upperMins.reserve(innerCnt);
+			for (size_t k = 0; k < innerCnt; k++) {
+				size_t n = level.size() / innerCnt + (k < level.size() % innerCnt ? 1 : 0);
+				upperMins.push_back(mins[used]);
+				Inner* inner = createInner();
+				try {
+					for (size_t c = 1; c < n; c++) {
+						inner->keys[c - 1] = mins[used + c];
+					}
+				}
+				catch (...) {
+					destroyNode(inner);
+					throw;
+				}
+				std::copy(level.begin() + used, level.begin() + used + n, inner->children);
+				inner->count = (unsigned short)(n - 1);
+				upper.push_back(inner);
+				used += n;
+			}
+			level.swap(upper);
+			mins.swap(upperMins);
+			upper.clear();
+			upperMins.clear();
+			used = 0;
+			++height;
+		}
+	}
+	catch (...) {
+		for (Node* node : upper) {
+			deleteAll(node);
+		}
+		for (size_t i = used; i < level.size(); i++) {
+			deleteAll(level[i]);
+		}
+		height = 0;
+		throw;
+	}
+	root = level[0];
+	size = cnt;
+}
+
+template<class T, class Alloc>
+template <class It>
+bool BPlusTree<T, Alloc>::buildFromSorted(It first, It last)
+{
+	//counting pass that also checks the order, so nothing is changed for wrong input
+	size_t cnt = 0;
+	for (It prev = first, it = first; it != last; prev = it++) {
+		if (cnt && !(*prev < *it)) return false;
+		++cnt;
+	}
+	BPlusTree<T, Alloc> built;
+	if (cnt) built.buildLevels(first, cnt);//may throw
+	*this = std::move(built);
+	return true;
+}
+
+template<class T, class Alloc>
+typename BPlusTree<T, Alloc>::Leaf* BPlusTree<T, Alloc>::findLeaf(const T& val) const noexcept
+{
+	Node* node = root;
+	while (!node->leaf) {
+		const Inner* inner = static_cast<const Inner*>(node);
+		node = inner->children[upperIndex(inner->keys, inner->count, val)];
+	}
+	return static_cast<Leaf*>(node);
+}
+
+template<class T, class Alloc>
+typename BPlusTree<T, Alloc>::Leaf* BPlusTree<T, Alloc>::firstLeaf() const noexcept
+{
+	Node* node = root;
+	if (!node) return nullptr;
+	while (!node->leaf) {
+		node = static_cast<const Inner*>(node)->children[0];
+	}
+	return static_cast<Leaf*>(node);
+}
+
+template<class T, class Alloc>
+bool BPlusTree<T, Alloc>::insertValue(const T& val)
+{
+	if (!root) {
+		Leaf* leaf = createLeaf();//may throw, nothing is changed yet
+		leaf->values[0] = val;
+		leaf->count = 1;
+		root = leaf;
+		height = 1;
+		return true;
+	}
+	Inner* path[MAX_HEIGHT];
+	size_t index[MAX_HEIGHT];
+	int depth = 0;
+	Node* node = root;
+	while (!node->leaf) {
+		Inner* inner = static_cast<Inner*>(node);
+		path[depth] = inner;
+		index[depth] = upperIndex(inner->keys, inner->count, val);
+		node = inner->children[index[depth++]];
+	}
+	Leaf* leaf = static_cast<Leaf*>(node);
+	size_t pos = lowerIndex(leaf->values, leaf->count, val);
+	if (pos < leaf->count && !(val < leaf->values[pos])) {//equal not permitted
+		return false;
+	}
+	if (leaf->count < LEAF_CAP) {
+		std::move_backward(leaf->values + pos, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+		leaf->values[pos] = val;
+		++leaf->count;
+		return true;
+	}
+	//the leaf and the full inner nodes above it are split, and a new root is needed if all of them are full
+	int fullInner = 0;
+	while (fullInner < depth && path[depth - 1 - fullInner]->count == INNER_CAP) fullInner++;
+	Inner* spare[MAX_HEIGHT + 1];
+	int spareCnt = 0;
+	Leaf* right = createLeaf();//may throw, nothing is changed yet
+	try {
+		for (; spareCnt < fullInner + (fullInner == depth ? 1 : 0); spareCnt++) {
+			spare[spareCnt] = createInner();
+		}
+	}
+	catch (...) {
+		while (spareCnt) destroyNode(spare[--spareCnt]);
+		destroyNode(right);
+		throw;
+	}
+	//split the leaf: CAP + 1 values, the left one keeps mid of them
+	const size_t mid = (LEAF_CAP + 1) / 2;
+	if (pos < mid) {
+		std::move(leaf->values + mid - 1, leaf->values + LEAF_CAP, right->values);
+		right->count = (unsigned short)(LEAF_CAP - mid + 1);
+		std::move_backward(leaf->values + pos, leaf->values + mid - 1, leaf->values + mid);
+		leaf->values[pos] = val;
+	}
+	else {
+		std::move(leaf->values + mid, leaf->values + pos, right->values);
+		right->values[pos - mid] = val;
+		std::move(leaf->values + pos, leaf->values + LEAF_CAP, right->values + pos - mid + 1);
+		right->count = (unsigned short)(LEAF_CAP + 1 - mid);
+	}
+	leaf->count = (unsigned short)mid;
+	right->next = leaf->next;
+	leaf->next = right;
+	//separator and new node that go to the parent
+	T sep = right->values[0];
+	Node* child = right;
+	for (int d = depth - 1; d >= 0; d--) {
+		Inner* inner = path[d];
+		size_t i = index[d];
+		if (inner->count < INNER_CAP) {
+			std::move_backward(inner->keys + i, inner->keys + inner->count, inner->keys + inner->count + 1);
+			std::move_backward(inner->children + i + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+			inner->keys[i] = std::move(sep);
+			inner->children[i + 1] = child;
+			++inner->count;
+			return true;
+		}
+		//split the inner node: CAP + 1 separators, the middle one goes up
+		T keys[INNER_CAP + 1];
+		Node* children[INNER_CAP + 2];
+		std::move(inner->keys, inner->keys + i, keys);
+		keys[i] = std::move(sep);
+		std::move(inner->keys + i, inner->keys + INNER_CAP, keys + i + 1);
+		std::copy(inner->children, inner->children + i + 1, children);
+		children[i + 1] = child;
+		std::copy(inner->children + i + 1, inner->children + INNER_CAP + 1, children + i + 2);
+		const size_t m = (INNER_CAP + 1) / 2;
+		Inner* split = spare[--spareCnt];
+		std::move(keys, keys + m, inner->keys);
+		std::copy(children, children + m + 1, inner->children);
+		inner->count = (unsigned short)m;
+		std::move(keys + m + 1, keys + INNER_CAP + 1, split->keys);
+		std::copy(children + m + 1, children + INNER_CAP + 2, split->children);
+		split->count = (unsigned short)(INNER_CAP - m);
+		sep = std::move(keys[m]);
+		child = split;
+	}
+	//the root was split
+	Inner* newRoot = spare[--spareCnt];
+	newRoot->keys[0] = std::move(sep);
+	newRoot->children[0] = root;
+	newRoot->children[1] = child;
+	newRoot->count = 1;
+	root = newRoot;
+	++height;
+	return true;
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::eraseChild(Inner* node, size_t k) noexcept
+{
+	std::move(node->keys + k + 1, node->keys + node->count, node->keys + k);
+	std::copy(node->children + k + 2, node->children + node->count + 1, node->children + k + 1);
+	--node->count;
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::fixLeaf(Leaf* leaf, Inner* parent, size_t i) noexcept
+{
+	Leaf* left = i > 0 ? static_cast<Leaf*>(parent->children[i - 1]) : nullptr;
+	Leaf* right = i < parent->count ? static_cast<Leaf*>(parent->children[i + 1]) : nullptr;
+	if (left && left->count > LEAF_MIN) {//take the last value of the left one
+		std::move_backward(leaf->values, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+		leaf->values[0] = std::move(left->values[--left->count]);
+		++leaf->count;
+		parent->keys[i - 1] = leaf->values[0];
+		return;
+	}
+	if (right && right->count > LEAF_MIN) {//take the first value of the right one
+		leaf->values[leaf->count++] = std::move(right->values[0]);
+		std::move(right->values + 1, right->values + right->count, right->values);
+		--right->count;
+		parent->keys[i] = right->values[0];
+		return;
+	}
+	//merge with a sibling, both together fit in one leaf
+	if (left) {
+		std::move(leaf->values, leaf->values + leaf->count, left->values + left->count);
+		left->count += leaf->count;
+		left->next = leaf->next;
+		destroyNode(leaf);
+		eraseChild(parent, i - 1);
+	}
+	else {
+		std::move(right->values, right->values + right->count, leaf->values + leaf->count);
+		leaf->count += right->count;
+		leaf->next = right->next;
+		destroyNode(right);
+		eraseChild(parent, i);
+	}
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::fixInner(Inner* node, Inner* parent, size_t i) noexcept
+{
+	Inner* left = i > 0 ? static_cast<Inner*>(parent->children[i - 1]) : nullptr;
+	Inner* right = i < parent->count ? static_cast<Inner*>(parent->children[i + 1]) : nullptr;
+	if (left && left->count > INNER_MIN) {//the separator comes down, the last one of the left goes up
+		std::move_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+		std::copy_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+		node->keys[0] = std::move(parent->keys[i - 1]);
+		node->children[0] = left->children[left->count];
+		parent->keys[i - 1] = std::move(left->keys[left->count - 1]);
+		--left->count;
+		++node->count;
+		return;
+	}
+	if (right && right->count > INNER_MIN) {//the separator comes down, the first one of the right goes up
+		node->keys[node->count] = std::move(parent->keys[i]);
+		node->children[node->count + 1] = right->children[0];
+		++node->count;
+		parent->keys[i] = std::move(right->keys[0]);
+		std::move(right->keys + 1, right->keys + right->count, right->keys);
+		std::copy(right->children + 1, right->children + right->count + 1, right->children);
+		--right->count;
+		return;
+	}
+	//merge with a sibling and the separator between them
+	Inner* into = left ? left : node;
+	Inner* from = left ? node : right;
+	size_t k = left ? i - 1 : i;
+	into->keys[into->count] = std::move(parent->keys[k]);
+	std::move(from->keys, from->keys + from->count, into->keys + into->count + 1);
+	std::copy(from->children, from->children + from->count + 1, into->children + into->count + 1);
+	into->count += from->count + 1;
+	destroyNode(from);
+	eraseChild(parent, k);
+}
+
+template<class T, class Alloc>
+bool BPlusTree<T, Alloc>::removeValue(const T& val) noexcept
+{
+	if (!root) return false;
+	Inner* path[MAX_HEIGHT];
+	size_t index[MAX_HEIGHT];
+	int depth = 0;
+	Node* node = root;
+	while (!node->leaf) {
+		Inner* inner = static_cast<Inner*>(node);
+		path[depth] = inner;
+		index[depth] = upperIndex(inner->keys, inner->count, val);
+		node = inner->children[index[depth++]];
+	}
+	Leaf* leaf = static_cast<Leaf*>(node);
+	size_t pos = lowerIndex(leaf->values, leaf->count, val);
+	if (pos == leaf->count || val < leaf->values[pos]) return false;
+	std::move(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+	--leaf->count;
+	if (depth == 0) {
+		if (!leaf->count) {
+			destroyNode(leaf);
+			root = nullptr;
+			height = 0;
+		}
+		return true;
+	}
+	if (leaf->count >= LEAF_MIN) return true;
+	fixLeaf(leaf, path[depth - 1], index[depth - 1]);
+	for (int d = depth - 1; d > 0 && path[d]->count < INNER_MIN; d--) {
+		fixInner(path[d], path[d - 1], index[d - 1]);
+	}
+	if (!root->leaf && !root->count) {//the root lost its last separator
+		Node* old = root;
+		root = static_cast<Inner*>(root)->children[0];
+		destroyNode(old);
+		--height;
+	}
+	return true;
+}
+
+template<class T, class Alloc>
+BPlusTree<T, Alloc>::BPlusTree(const BPlusTree<T, Alloc>& other)
+{
+	Leaf* prevLeaf = nullptr;
+	if (other.root) root = copyNode(other.root, prevLeaf);
+	size = other.size;
+	height = other.height;
+}
+
+template<class T, class Alloc>
+BPlusTree<T, Alloc>::BPlusTree(BPlusTree<T, Alloc>&& other) noexcept
+	:BPlusTree<T, Alloc>()
+{
+	std::swap(other.root, root);
+	std::swap(other.size, size);
+	std::swap(other.height, height);
+	alloc.swap(other.alloc);
+}
+
+template<class T, class Alloc>
+BPlusTree<T, Alloc>& BPlusTree<T, Alloc>::operator=(const BPlusTree<T, Alloc>& other)
+{
+	if (&other != this) {
+		BPlusTree<T, Alloc> copy(other);//may throw, nothing is changed yet
+		*this = std::move(copy);
+	}
+	return *this;
+}
+
+template<class T, class Alloc>
+BPlusTree<T, Alloc>& BPlusTree<T, Alloc>::operator=(BPlusTree<T, Alloc>&& other) noexcept
+{
+	if (&other != this) {
+		clearData();
+		std::swap(other.root, root);
+		std::swap(other.size, size);
+		std::swap(other.height, height);
+		alloc.swap(other.alloc);
+	}
+	return *this;
+}
+
+template<class T, class Alloc>
+BPlusTree<T, Alloc>::~BPlusTree() noexcept
+{
+	clearData();
+}
+
+template<class T, class Alloc>
+size_t BPlusTree<T, Alloc>::getSize() const noexcept
+{
+	return size;
+}
+
+template<class T, class Alloc>
+bool BPlusTree<T, Alloc>::insert(const T& key)
+{
+	//repetitions are reported through the return value, no exception is thrown for them
+	if (!insertValue(key)) return false;
+	++size;
+	return true;
+}
+
+template<class T, class Alloc>
+bool BPlusTree<T, Alloc>::remove(const T& key) noexcept
+{
+	if (!removeValue(key)) return false;
+	--size;
+	return true;
+}
+
+template<class T, class Alloc>
+bool BPlusTree<T, Alloc>::exists(const T& key) const noexcept
+{
+	if (!root) return false;
+	const Leaf* leaf = findLeaf(key);
+	size_t pos = lowerIndex(leaf->values, leaf->count, key);
+	return pos < leaf->count && !(key < leaf->values[pos]);
+}
+
+template<class T, class Alloc>
+const T* BPlusTree<T, Alloc>::lowerBound(const T& key) const noexcept
+{
+	if (!root) return nullptr;
+	const Leaf* leaf = findLeaf(key);
+	size_t pos = lowerIndex(leaf->values, leaf->count, key);
+	if (pos < leaf->count) return &leaf->values[pos];
+	//all values of a leaf are less than the first one of the next leaf
+	return leaf->next ? &leaf->next->values[0] : nullptr;
+}
+
+template<class T, class Alloc>
+const T* BPlusTree<T, Alloc>::upperBound(const T& key) const noexcept
+{
+	if (!root) return nullptr;
+	const Leaf* leaf = findLeaf(key);
+	size_t pos = upperIndex(leaf->values, leaf->count, key);
+	if (pos < leaf->count) return &leaf->values[pos];
+	return leaf->next ? &leaf->next->values[0] : nullptr;
+}
+
+template<class T, class Alloc>
+template <class F>
+void BPlusTree<T, Alloc>::forEachInRange(const T& lo, const T& hi, F f) const
+{
+	if (!root || !(lo < hi)) return;
+	const Leaf* leaf = findLeaf(lo);
+	size_t pos = lowerIndex(leaf->values, leaf->count, lo);
+	for (; leaf; leaf = leaf->next, pos = 0) {
+		for (; pos < leaf->count; pos++) {
+			if (!(leaf->values[pos] < hi)) return;
+			f(leaf->values[pos]);
+		}
+	}
+}
+
+template<class T, class Alloc>
+size_t BPlusTree<T, Alloc>::getHeight() const noexcept
+{
+	return height;
+}
+
+template<class T, class Alloc>
+void BPlusTree<T, Alloc>::clearData() noexcept
+{
+	if (!Alloc::BULK_RELEASE || !std::is_trivially_destructible<T>::value) {
+		deleteAll(root);
+	}
+	alloc.release();
+	root = nullptr;
+	size = 0;
+	height = 0;
+}
+
+template<class T, class Alloc>
+BPlusIterator<T, Alloc> BPlusTree<T, Alloc>::begin() const noexcept
+{
+	return BPlusIterator<T, Alloc>(firstLeaf());
+}
+
+template<class T, class Alloc>
+BPlusIterator<T, Alloc> BPlusTree<T, Alloc>::end() const noexcept
+{
+	return BPlusIterator<T, Alloc>(nullptr);
+}
+
+template<class T, class Alloc>
+size_t BPlusTree<T, Alloc>::getBytesUsed() const noexcept
+{
+	return alloc.getBytesUsed() + sizeof(BPlusTree<T, Alloc>);
+}
+
+template<class T, class Alloc>
+BPlusIterator<T, Alloc>::BPlusIterator(const typename BPlusTree<T, Alloc>::Leaf* leaf) noexcept
+	: leaf(leaf), pos(0)
+{
+}
+
+template<class T, class Alloc>
+BPlusIterator<T, Alloc>& BPlusIterator<T, Alloc>::operator++() noexcept
+{
+	if (leaf && ++pos == leaf->count) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+	return *this;
+}
+
+template<class T, class Alloc>
+const T* BPlusIterator<T, Alloc>::operator*() const noexcept
+{
+	return leaf ? &leaf->values[pos] : nullptr;
+}
+
+template<class T, class Alloc>
+bool BPlusIterator<T, Alloc>::operator==(const BPlusIterator<T, Alloc>& other) const noexcept
+{
+	return operator*() == *other;
+}
+
+template<class T, class Alloc>
+bool BPlusIterator<T, Alloc>::operator!=(const BPlusIterator<T, Alloc>& other) const noexcept
+{
+	return operator*() != *other;
+}
@@ -0,0 +1,477 @@
+#pragma once
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "T_BenchTimer.h"
+
+/// @brief Result of one operation of one structure in one benchmark phase.
+/// samples are the average nanoseconds per operation of each block timed repetition
+struct BenchResult {
+	std::string phase, op, structure;
+	std::vector<double> samples;
+	double mean = 0, stddev = 0;
+	uint64_t p50 = 0, p99 = 0;
+	double memory = 0;
+
+	/// @brief Sets mean and stddev (sample standard deviation) from the samples
+	void summarize() noexcept
+	{
+		mean = stddev = 0;
+		if (samples.empty()) return;
+		for (double s : samples) mean += s;
+		mean /= (double)samples.size();
+		if (samples.size() < 2) return;
+		for (double s : samples) stddev += (s - mean) * (s - mean);
+		stddev = std::sqrt(stddev / (double)(samples.size() - 1));
+	}
+	/// @brief Returns the key that identifies the same result in another report
+	std::string key() const { return phase + "/" + op + "/" + structure; }
+};
+
+/// @brief Returns the 97.5% quantile of Student's t distribution (two-sided 95%) for df degrees of freedom.
+/// Table values up to 5 degrees of freedom (interpolated between them), then the Cornish-Fisher expansion
+/// around the normal quantile, which is within 0.005 of it there
+inline double studentT975(double df) noexcept
+{
+	const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571 };
+	if (df <= 1) return table[0];
+	if (df < 5) {
+		int i = (int)df;
+		return table[i - 1] + (table[i] - table[i - 1]) * (df - i);
+	}
+	const double z = 1.959963985;
+	const double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+	return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df) +
+		(3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * df * df * df);
+}
+
+/// @brief Returns the half width of the 95% confidence interval of the mean of a result. 0 for less than 2 samples
+inline double confidence95(const BenchResult& r) noexcept
+{
+	size_t n = r.samples.size();
+	return n < 2 ? 0 : studentT975((double)(n - 1)) * r.stddev / std::sqrt((double)n);
+}
+
+/// @brief Comparison of one result with the same result of a baseline
+struct BenchComparison {
+	const BenchResult* baseline;
+	const BenchResult* current;
+	/// @brief Change of the mean in percent. Positive when slower
+	double changePercent = 0;
+	/// @brief If the difference of the means is significant at 95% by Welch's t-test
+	bool significant = false;
+	/// @brief Significant and slower by more than the threshold
+	bool regression = false;
+};
+
+/// @brief Compares the results with the same phase, operation and structure.
+/// A regression is a significant slowdown (Welch's t-test, 95%) bigger than thresholdPercent
+inline BenchComparison compareResults(const BenchResult& baseline, const BenchResult& current, double thresholdPercent)
+{
+	BenchComparison c{ &baseline, &current };
+	if (baseline.mean <= 0) return c;
+	c.changePercent = (current.mean - baseline.mean) * 100 / baseline.mean;
+	double n1 = (double)baseline.samples.size(), n2 = (double)current.samples.size();
+	if (n1 < 2 || n2 < 2) return c;
+	double v1 = baseline.stddev * baseline.stddev / n1, v2 = current.stddev * current.stddev / n2;
+	double diff = current.mean - baseline.mean;
+	if (v1 + v2 <= 0) {
+		c.significant = diff != 0;
+	}
+	else {
+		//Welch-Satterthwaite degrees of freedom
+		double df = (v1 + v2) * (v1 + v2) / (v1 * v1 / (n1 - 1) + v2 * v2 / (n2 - 1));
+		c.significant = std::fabs(diff) / std::sqrt(v1 + v2) > studentT975(df);
+	}
+	c.regression = c.significant && c.changePercent > thresholdPercent;
+	return c;
+}
+
+/// @brief Returns the model name of the processor. "unknown" if it can not be found
+inline std::string cpuModel()
+{
+	std::string model;
+#if BENCH_HAS_TSC
+	//brand string of cpuid leaves 0x80000002 - 0x80000004
+	unsigned regs[12] = { 0 };
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0x80000000);
+	if ((unsigned)info[0] >= 0x80000004u) {
+		for (int i = 0; i < 3; i++) {
+			__cpuid(info, 0x80000002 + i);
+			for (int j = 0; j < 4; j++) regs[i * 4 + j] = (unsigned)info[j];
+		}
+	}
+#else
+	for (int i = 0; i < 3; i++) {
+		if (!__get_cpuid(0x80000002 + i, &regs[i * 4], &regs[i * 4 + 1], &regs[i * 4 + 2], &regs[i * 4 + 3])) break;
+	}
+#endif
+	model.assign(reinterpret_cast<const char*>(regs), sizeof(regs));
+	model = model.substr(0, model.find('\0'));
+#endif
+	if (model.empty()) {
+		std::ifstream cpuinfo("/proc/cpuinfo");
+		std::string line;
+		while (std::getline(cpuinfo, line)) {
+			if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+				model = line.substr(line.find(':') + 1);
+				break;
+			}
+		}
+	}
+	size_t b = model.find_first_not_of(' '), e = model.find_last_not_of(' ');
+	return b == std::string::npos ? "unknown" : model.substr(b, e - b + 1);
+}
+
+/// @brief Returns the compiler, its settings and the machine that the benchmark was built for and runs on.
+/// Compiler flags are not visible at run time: the settings come from predefined macros, and a build can
+/// give its command line in BENCH_BUILD_FLAGS
+inline std::map<std::string, std::string> benchEnvironment()
+{
+	std::map<std::string, std::string> env;
+#if defined(_MSC_VER) && !defined(__clang__)
+	env["compiler"] = "MSVC " + std::to_string(_MSC_FULL_VER);
+#elif defined(__clang__)
+	env["compiler"] = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	env["compiler"] = "gcc " __VERSION__;
+#else
+	env["compiler"] = "unknown";
+#endif
+	std::string flags;
+#ifdef NDEBUG
+	flags += "NDEBUG ";
+#endif
+#if defined(__OPTIMIZE__)
+	flags += "optimized ";
+#endif
+#if defined(_DEBUG)
+	flags += "_DEBUG ";
+#endif
+#if defined(__AVX512F__)
+	flags += "AVX512F ";
+#endif
+#if defined(__AVX2__)
+	flags += "AVX2 ";
+#endif
+#if defined(__SSE4_2__)
+	flags += "SSE4.2 ";
+#endif
+#if defined(_MSVC_LANG)
+	flags += "C++" + std::to_string(_MSVC_LANG);
+#else
+	flags += "C++" + std::to_string(__cplusplus);
+#endif
+#ifdef BENCH_BUILD_FLAGS
+	flags += std::string(" ") + BENCH_BUILD_FLAGS;
+#endif
+	env["flags"] = flags;
+#if defined(_M_X64) || defined(__x86_64__)
+	env["arch"] = "x64";
+#elif defined(_M_IX86) || defined(__i386__)
+	env["arch"] = "x86";
+#elif defined(_M_ARM64) || defined(__aarch64__)
+	env["arch"] = "arm64";
+#else
+	env["arch"] = "unknown";
+#endif
+#if defined(_WIN32)
+	env["os"] = "windows";
+#elif defined(__linux__)
+	env["os"] = "linux";
+#elif defined(__APPLE__)
+	env["os"] = "macos";
+#else
+	env["os"] = "unknown";
+#endif
+	env["cpu"] = cpuModel();
+	char date[32];
+	std::time_t now = std::time(nullptr);
+	std::tm utc;
+#if defined(_MSC_VER)
+	gmtime_s(&utc, &now);
+#else
+	gmtime_r(&now, &utc);
+#endif
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &utc);
+	env["date"] = date;
+	return env;
+}
+
+/// @brief Results of a benchmark run with its settings and environment. Saved as JSON or CSV and read back for comparisons
+struct BenchReport {
+	/// @brief Settings and environment as text (element count, seed, compiler ...)
+	std::map<std::string, std::string> info;
+	std::vector<BenchResult> results;
+
+	/// @brief Returns the result with the same key. Null if there is none
+	const BenchResult* find(const std::string& key) const
+	{
+		for (const BenchResult& r : results) {
+			if (r.key() == key) return &r;
+		}
+		return nullptr;
+	}
+	void writeJson(std::ostream& out) const
+	{
+		out << "{\n  \"info\": {";
+		const char* sep = "\n";
+		for (const auto& item : info) {
+			out << sep << "    " << quoted(item.first) << ": " << quoted(item.second);
+			sep = ",\n";
+		}
+		out << "\n  },\n  \"results\": [";
+		sep = "\n";
+		for (const BenchResult& r : results) {
+			out << sep << "    {\"phase\": " << quoted(r.phase) << ", \"op\": " << quoted(r.op) <<
+				", \"structure\": " << quoted(r.structure) << ", \"mean_ns\": " << number(r.mean) <<
+				", \"stddev_ns\": " << number(r.stddev) << ", \"ci95_ns\": " << number(confidence95(r)) <<
+				", \"p50_ns\": " << r.p50 << ", \"p99_ns\": " << r.p99 << ", \"memory_bytes\": " << number(r.memory) <<
+				", \"samples_ns\": [";
+			for (size_t i = 0; i < r.samples.size(); i++) {
+				out << (i ? ", " : "") << number(r.samples[i]);
+			}
+			out << "]}";
+			sep = ",\n";
+		}
+		out << "\n  ]\n}\n";
+	}
+	/// @brief Writes the info as "# name,value" lines and then one line for each result. Samples are separated by ';'
+	void writeCsv(std::ostream& out) const
+	{
+		for (const auto& item : info) {
+			out << "# " << csvField(item.first) << "," << csvField(item.second) << "\n";
+		}
+		out << "phase,op,structure,mean_ns,stddev_ns,ci95_ns,p50_ns,p99_ns,memory_bytes,samples_ns\n";
+		for (const BenchResult& r : results) {
+			out << csvField(r.phase) << "," << csvField(r.op) << "," << csvField(r.structure) << "," <<
+				number(r.mean) << "," << number(r.stddev) << "," << number(confidence95(r)) << "," <<
+				r.p50 << "," << r.p99 << "," << number(r.memory) << ",";
+			for (size_t i = 0; i < r.samples.size(); i++) {
+				out << (i ? ";" : "") << number(r.samples[i]);
+			}
+			out << "\n";
+		}
+	}
+	/// @brief Saves to a file as CSV or JSON
+	/// @throws std::runtime_error if the file can not be written
+	void save(const std::string& path, bool csv) const
+	{
+		std::ofstream out(path);
+		if (!out) throw std::runtime_error("Cannot write " + path);
+		if (csv) writeCsv(out);
+		else writeJson(out);
+		if (!out) throw std::runtime_error("Cannot write " + path);
+	}
+	/// @brief Reads a report saved with save(). JSON starts with '{', anything else is read as CSV
+	/// @throws std::runtime_error if the file can not be read or is not such report
+	static BenchReport load(const std::string& path)
+	{
+		std::ifstream in(path);
+		if (!in) throw std::runtime_error("Cannot open " + path);
+		std::stringstream text;
+		text << in.rdbuf();
+		const std::string content = text.str();
+		size_t start = content.find_first_not_of(" \t\r\n");
+		return start != std::string::npos && content[start] == '{' ? parseJson(content) : parseCsv(content);
+	}
+private:
+	static std::string number(double value)
+	{
+		char buf[32];
+		//JSON has no nan or inf
+		std::snprintf(buf, sizeof(buf), "%.6g", std::isfinite(value) ? value : 0.0);
+		return buf;
+	}
+	static std::string quoted(const std::string& s)
+	{
+		std::string out = "\"";
+		for (char ch : s) {
+			if (ch == '"' || ch == '\\') out += '\\';
+			if ((unsigned char)ch < 0x20) out += ' ';
+			else out += ch;
+		}
+		return out + "\"";
+	}
+	static std::string csvField(const std::string& s)
+	{
+		if (s.find_first_of(",\"\n") == std::string::npos) return s;
+		std::string out = "\"";
+		for (char ch : s) {
+			if (ch == '"') out += '"';
+			out += ch;
+		}
+		return out + "\"";
+	}
+	/// @brief Splits a CSV line into fields, with quoted fields
+	static std::vector<std::string> csvFields(const std::string& line)
+	{
+		std::vector<std::string> fields(1);
+		bool inQuotes = false;
+		for (size_t i = 0; i < line.size(); i++) {
+			char ch = line[i];
+			if (inQuotes) {
+				if (ch != '"') fields.back() += ch;
+				else if (i + 1 < line.size() && line[i + 1] == '"') fields.back() += line[++i];
+				else inQuotes = false;
+			}
+			else if (ch == '"') inQuotes = true;
+			else if (ch == ',') fields.emplace_back();
+			else if (ch != '\r') fields.back() += ch;
+		}
+		return fields;
+	}
+	static BenchReport parseCsv(const std::string& text)
+	{
+		BenchReport report;
+		std::istringstream in(text);
+		std::string line;
+		bool header = false;
+		while (std::getline(in, line)) {
+			if (line.empty()) continue;
+			if (line.compare(0, 2, "# ") == 0) {
+				std::vector<std::string> f = csvFields(line.substr(2));
+				if (f.size() == 2) report.info[f[0]] = f[1];
+				continue;
+			}
+			if (!header) {
+				header = true;
+				continue;
+			}
+			std::vector<std::string> f = csvFields(line);
+			if (f.size() != 10) throw std::runtime_error("Not a benchmark CSV line: " + line);
+			BenchResult r;
+			r.phase = f[0];
+			r.op = f[1];
+			r.structure = f[2];
+			r.p50 = std::strtoull(f[6].c_str(), nullptr, 10);
+			r.p99 = std::strtoull(f[7].c_str(), nullptr, 10);
+			r.memory = std::atof(f[8].c_str());
+			std::istringstream samples(f[9]);
+			std::string sample;
+			while (std::getline(samples, sample, ';')) {
+				r.samples.push_back(std::atof(sample.c_str()));
+			}
+			r.summarize();
+			report.results.push_back(r);
+		}
+		return report;
+	}
+
+	/// @brief Reader for the JSON that writeJson() makes: objects, arrays, strings and numbers
+	class JsonReader {
+	private:
+		const std::string& text;
+		size_t pos = 0;
+	public:
+		explicit JsonReader(const std::string& text) : text(text) {}
+		void fail(const char* what) const
+		{
+			throw std::runtime_error(std::string("Bad benchmark JSON: ") + what + " at " + std::to_string(pos));
+		}
+		/// @brief Skips spaces and returns the next char (0 at the end) without taking it
+		char peek()
+		{
+			while (pos < text.size() && std::isspace((unsigned char)text[pos])) pos++;
+			return pos < text.size() ? text[pos] : 0;
+		}
+		void expect(char ch)
+		{
+			if (peek() != ch) fail("unexpected char");
+			pos++;
+		}
+		/// @brief Takes the char if it is next
+		bool accept(char ch)
+		{
+			if (peek() != ch) return false;
+			pos++;
+			return true;
+		}
+		std::string string()
+		{
+			expect('"');
+			std::string out;
+			while (pos < text.size() && text[pos] != '"') {
+				if (text[pos] == '\\') pos++;
+				if (pos < text.size()) out += text[pos++];
+			}
+			if (pos >= text.size()) fail("unterminated string");
+			pos++;
+			return out;
+		}
+		double number()
+		{
+			peek();
+			const char* begin = text.c_str() + pos;
+			char* end = nullptr;
+			double value = std::strtod(begin, &end);
+			if (end == begin) fail("number expected");
+			pos += end - begin;
+			return value;
+		}
+		/// @brief Calls f(name) for each member of an object. f must read the member's value
+		template <class F>
+		void object(F f)
+		{
+			expect('{');
+			if (accept('}')) return;
+			do {
+				std::string name = string();
+				expect(':');
+				f(name);
+			} while (accept(','));
+			expect('}');
+		}
+		/// @brief Calls f() for each item of an array. f must read the item
+		template <class F>
+		void array(F f)
+		{
+			expect('[');
+			if (accept(']')) return;
+			do {
+				f();
+			} while (accept(','));
+			expect(']');
+		}
+	};
+	static BenchReport parseJson(const std::string& text)
+	{
+		BenchReport report;
+		JsonReader json(text);
+		json.object([&](const std::string& section) {
+			if (section == "info") {
+				json.object([&](const std::string& name) { report.info[name] = json.string(); });
+			}
+			else if (section == "results") {
+				json.array([&]() {
+					BenchResult r;
+					json.object([&](const std::string& name) {
+						if (name == "phase") r.phase = json.string();
+						else if (name == "op") r.op = json.string();
+						else if (name == "structure") r.structure = json.string();
+						else if (name == "samples_ns") json.array([&]() { r.samples.push_back(json.number()); });
+						else if (name == "p50_ns") r.p50 = (uint64_t)json.number();
+						else if (name == "p99_ns") r.p99 = (uint64_t)json.number();
+						else if (name == "memory_bytes") r.memory = json.number();
+						else json.number(); //mean, stddev and ci95 come again from the samples
+					});
+					r.summarize();
+					report.results.push_back(r);
+				});
+			}
+			else json.fail("unknown section");
+		});
+		return report;
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+#if defined(_MSC_VER) && !BENCH_HAS_TSC
+#include <intrin.h>
+#endif
+
+/// @brief Returns if the processor has a time stamp counter that ticks with constant rate
+/// in all power states (invariant TSC), so it can be used as a clock
+inline bool hasInvariantTsc() noexcept
+{
+#if BENCH_HAS_TSC && defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0x80000000);
+	if ((unsigned)regs[0] < 0x80000007u) return false;
+	__cpuid(regs, 0x80000007);
+	return (regs[3] & (1 << 8)) != 0;
+#elif BENCH_HAS_TSC
+	unsigned a, b, c, d;
+	if (!__get_cpuid(0x80000007, &a, &b, &c, &d)) return false;
+	return (d & (1u << 8)) != 0;
+#else
+	return false;
+#endif
+}
+
+/// @brief Makes the compiler keep the computation of a value that is not used otherwise,
+/// so timed lookups are not removed from the timed loops
+template <class V>
+inline void keepValue(const V& value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const V* sink;
+	sink = &value;
+	(void)sink;
+	_ReadWriteBarrier();
+#endif
+}
+
+/// @brief Clock for timing single operations and blocks of operations.
+/// Uses the fenced time stamp counter (rdtsc at the start, rdtscp at the end) when it is invariant,
+/// else steady_clock. Its own cost is measured once and subtracted from every time it gives
+class BenchClock {
+private:
+	//data
+	/// @brief If the time stamp counter is used
+	bool tsc = false;
+	/// @brief Nanoseconds in one tick
+	double nsPerTick = 1;
+	/// @brief Ticks that a start() and stop() with nothing between them take (median)
+	uint64_t overhead = 0;
+
+	//private methods
+	/// @brief Returns steady_clock time in nanoseconds
+	static uint64_t steadyNs() noexcept
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+public:
+	/// @brief Constructor that chooses the clock, finds its rate and measures its cost
+	/// @param useTsc False to use steady_clock even when there is a usable time stamp counter
+	explicit BenchClock(bool useTsc = true)
+	{
+		tsc = useTsc && BENCH_HAS_TSC && hasInvariantTsc();
+		if (tsc) {
+			//rate against steady_clock over about 20ms
+			uint64_t ns0 = steadyNs(), t0 = start();
+			uint64_t ns1 = ns0;
+			while (ns1 - ns0 < 20000000) ns1 = steadyNs();
+			uint64_t t1 = stop();
+			nsPerTick = (double)(ns1 - ns0) / (double)(t1 - t0);
+		}
+		const int SAMPLES = 1001;
+		std::vector<uint64_t> empty(SAMPLES);
+		for (int i = 0; i < SAMPLES; i++) {
+			uint64_t t = start();
+			empty[i] = stop() - t;
+		}
+		std::nth_element(empty.begin(), empty.begin() + SAMPLES / 2, empty.end());
+		overhead = empty[SAMPLES / 2];
+	}
+	/// @brief Returns the tick at the start of a timed code. Later loads do not start before it
+	uint64_t start() const noexcept
+	{
+#if BENCH_HAS_TSC
+		if (tsc) {
+			_mm_lfence();
+			uint64_t t = __rdtsc();
+			_mm_lfence();
+			return t;
+		}
+#endif
+		return steadyNs();
+	}
+	/// @brief Returns the tick at the end of a timed code. Waits for the code before it to finish
+	uint64_t stop() const noexcept
+	{
+#if BENCH_HAS_TSC
+		if (tsc) {
+			unsigned aux;
+			uint64_t t = __rdtscp(&aux);
+			_mm_lfence();
+			return t;
+		}
+#endif
+		return steadyNs();
+	}
+	/// @brief Returns nanoseconds for ticks between a start() and a stop() without the clock's own cost
+	double toNs(uint64_t ticks) const noexcept
+	{
+		return ticks > overhead ? (double)(ticks - overhead) * nsPerTick : 0;
+	}
+	/// @brief Returns the nanoseconds per call of op(i) for i from 0 to n - 1 timed as one block
+	template <class F>
+	double timeBlock(size_t n, F op) const
+	{
+		if (!n) return 0;
+		uint64_t t = start();
+		for (size_t i = 0; i < n; i++) {
+			op(i);
+		}
+		return toNs(stop() - t) / (double)n;
+	}
+	/// @brief Returns if the time stamp counter is used
+	bool usesTsc() const noexcept { return tsc; }
+	/// @brief Returns the cost of the clock itself in nanoseconds
+	double getOverheadNs() const noexcept { return (double)overhead * nsPerTick; }
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define BLOCK_SEARCH_X86 1
+#define BLOCK_SEARCH_TARGET(isa)
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLOCK_SEARCH_X86 1
+/// @brief The vector functions are compiled for their instruction set alone, so the rest of the
+/// program needs no -mavx2 and runs on processors without it
+#define BLOCK_SEARCH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BLOCK_SEARCH_X86 0
+#define BLOCK_SEARCH_TARGET(isa)
+#endif
+
+/// @brief Vector instructions that the block search can use, from the least to the most
+enum class SimdLevel { SCALAR, SSE42, AVX2 };
+
+/// @brief Returns the best SimdLevel that the processor and the OS support (the OS has to save the AVX registers)
+inline SimdLevel detectSimdLevel() noexcept
+{
+#if BLOCK_SEARCH_X86 && defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+	int maxLeaf = regs[0];
+	__cpuid(regs, 1);
+	bool sse42 = (regs[2] & (1 << 20)) && (regs[2] & (1 << 23)); //with popcnt
+	bool osAvx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	if (sse42 && osAvx && maxLeaf >= 7) {
+		__cpuidex(regs, 7, 0);
+		if (regs[1] & (1 << 5)) return SimdLevel::AVX2;
+	}
+	return sse42 ? SimdLevel::SSE42 : SimdLevel::SCALAR;
+#elif BLOCK_SEARCH_X86
+	__builtin_cpu_init();
+	bool sse42 = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+	if (sse42 && __builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+	return sse42 ? SimdLevel::SSE42 : SimdLevel::SCALAR;
+#else
+	return SimdLevel::SCALAR;
+#endif
+}
+
+/// @brief Returns the SimdLevel of the processor. Detected once
+inline SimdLevel simdLevel() noexcept
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+#if BLOCK_SEARCH_X86
+/// @brief Returns the number of keys less than val for 32-bit keys, 8 compared at once.
+/// flip is xor-ed into keys and val: the sign bit for unsigned keys, so the signed compare orders them right
+BLOCK_SEARCH_TARGET("avx2,popcnt")
+inline size_t countLessAvx2(const int32_t* keys, size_t cnt, int32_t val, int32_t flip) noexcept
+{
+	const __m256i f = _mm256_set1_epi32(flip);
+	const __m256i v = _mm256_set1_epi32(val ^ flip);
+	size_t n = 0, i = 0;
+	for (; i + 8 <= cnt; i += 8) {
+		__m256i k = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), f);
+		n += _mm_popcnt_u32((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, k))));
+	}
+	for (; i < cnt; i++) {
+		n += (keys[i] ^ flip) < (val ^ flip);
+	}
+	return n;
+}
+
+/// @brief Same as above for 64-bit keys, 4 compared at once
+BLOCK_SEARCH_TARGET("avx2,popcnt")
+inline size_t countLessAvx2(const int64_t* keys, size_t cnt, int64_t val, int64_t flip) noexcept
+{
+	const __m256i f = _mm256_set1_epi64x(flip);
+	const __m256i v = _mm256_set1_epi64x(val ^ flip);
+	size_t n = 0, i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		__m256i k = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), f);
+		n += _mm_popcnt_u32((unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, k))));
+	}
+	for (; i < cnt; i++) {
+		n += (keys[i] ^ flip) < (val ^ flip);
+	}
+	return n;
+}
+
+/// @brief Same as above with 128-bit registers, 4 keys compared at once
+BLOCK_SEARCH_TARGET("sse4.2,popcnt")
+inline size_t countLessSse42(const int32_t* keys, size_t cnt, int32_t val, int32_t flip) noexcept
+{
+	const __m128i f = _mm_set1_epi32(flip);
+	const __m128i v = _mm_set1_epi32(val ^ flip);
+	size_t n = 0, i = 0;
+	for (; i + 4 <= cnt; i += 4) {
+		__m128i k = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), f);
+		n += _mm_popcnt_u32((unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, k))));
+	}
+	for (; i < cnt; i++) {
+		n += (keys[i] ^ flip) < (val ^ flip);
+	}
+	return n;
+}
+
+/// @brief Same as above for 64-bit keys, 2 compared at once (pcmpgtq is SSE4.2)
+BLOCK_SEARCH_TARGET("sse4.2,popcnt")
+inline size_t countLessSse42(const int64_t* keys, size_t cnt, int64_t val, int64_t flip) noexcept
+{
+	const __m128i f = _mm_set1_epi64x(flip);
+	const __m128i v = _mm_set1_epi64x(val ^ flip);
+	size_t n = 0, i = 0;
+	for (; i + 2 <= cnt; i += 2) {
+		__m128i k = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), f);
+		n += _mm_popcnt_u32((unsigned)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, k))));
+	}
+	for (; i < cnt; i++) {
+		n += (keys[i] ^ flip) < (val ^ flip);
+	}
+	return n;
+}
+#endif
+
+/// @brief Rank search in a block of sorted keys, as the nodes of the B+ tree and the blocks of the
+/// Unrolled Skip List keep them. Any T uses std::lower_bound/upper_bound
+template <class T, class Enable = void>
+struct BlockSearch {
+	/// @brief Returns the number of keys less than val. level is not used
+	static size_t lowerIndex(const T* keys, size_t cnt, const T& val, SimdLevel = SimdLevel::SCALAR) noexcept
+	{
+		return std::lower_bound(keys, keys + cnt, val) - keys;
+	}
+	/// @brief Returns the number of keys not greater than val. level is not used
+	static size_t upperIndex(const T* keys, size_t cnt, const T& val, SimdLevel = SimdLevel::SCALAR) noexcept
+	{
+		return std::upper_bound(keys, keys + cnt, val) - keys;
+	}
+};
+
+/// @brief Rank search for 32 and 64-bit integral keys. A sorted block has the keys less than val at its start,
+/// so their number is found by comparing val with all keys, 8 or 4 of them at once with AVX2 (SSE4.2 for
+/// older processors, one by one without both), with no branches that depend on the keys.
+/// Big blocks are first halved by binary search down to LINEAR_MAX keys
+template <class T>
+struct BlockSearch<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+	/// @brief Most keys that are compared one after another
+	static const size_t LINEAR_MAX = 64;
+	/// @brief Signed type of the same size, that the vector compares take
+	typedef typename std::conditional<sizeof(T) == 4, int32_t, int64_t>::type Signed;
+
+	/// @brief Returns the number of keys less than val, using the given level (detected by default)
+	static size_t lowerIndex(const T* keys, size_t cnt, const T& val, SimdLevel level = simdLevel()) noexcept
+	{
+		size_t base = 0;
+		while (cnt > LINEAR_MAX) {
+			size_t half = cnt / 2;
+			if (keys[base + half - 1] < val) {
+				base += half;
+				cnt -= half;
+			}
+			else cnt = half;
+		}
+		const Signed flip = std::is_signed<T>::value ? 0 : std::numeric_limits<Signed>::min();
+		const Signed* block = reinterpret_cast<const Signed*>(keys + base);
+#if BLOCK_SEARCH_X86
+		if (level == SimdLevel::AVX2) return base + countLessAvx2(block, cnt, (Signed)val, flip);
+		if (level == SimdLevel::SSE42) return base + countLessSse42(block, cnt, (Signed)val, flip);
+#endif
+		(void)level;
+		size_t n = 0;
+		for (size_t i = 0; i < cnt; i++) {
+			n += (block[i] ^ flip) < ((Signed)val ^ flip);
+		}
+		return base + n;
+	}
+	/// @brief Returns the number of keys not greater than val: the keys less than val + 1
+	static size_t upperIndex(const T* keys, size_t cnt, const T& val, SimdLevel level = simdLevel()) noexcept
+	{
+		if (val == std::numeric_limits<T>::max()) return cnt;
+		return lowerIndex(keys, cnt, (T)(val + 1), level);
+	}
+};
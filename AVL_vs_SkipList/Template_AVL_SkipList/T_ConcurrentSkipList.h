@@ -0,0 +1,634 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#include "T_LevelGenerator.h"
+
+/// @brief Maximum number of threads that can work with concurrent skip lists at the same time
+const int CSL_MAX_THREADS = 128;
+
+/// @brief Returns the index of the calling thread between 0 and CSL_MAX_THREADS - 1.
+/// Indexes are given on the first call of a thread and taken back when it ends
+inline int concurrentThreadIndex()
+{
+	static std::atomic<bool> used[CSL_MAX_THREADS];
+	struct Holder {
+		int index = -1;
+		Holder()
+		{
+			for (int i = 0; i < CSL_MAX_THREADS; i++) {
+				bool expected = false;
+				if (used[i].compare_exchange_strong(expected, true)) {
+					index = i;
+					return;
+				}
+			}
+			throw std::length_error("Too many threads use concurrent skip lists");
+		}
+		~Holder()
+		{
+			used[index].store(false);
+		}
+	};
+	thread_local Holder holder;
+	return holder.index;
+}
+
+template <class T>
+class CSListIterator;
+
+/// @brief Lock-free SkipList with no repeating elements allowed.
+/// Levels are linked with CAS. A removed node is first marked in all of its next pointers (logical
+/// deletion) and then unlinked by any thread that passes it. Unlinked nodes are freed with
+/// epoch based reclamation once no thread can still see them
+template <class T>
+class ConcurrentSkipList
+{
+private:
+	struct CSLNode
+	{
+		/// @brief CSLNode's given value
+		T value;
+		/// @brief The lvl of the CSLNode - number of pointers that it has
+		const int lvl;
+		/// @brief Number of the inserter and the remover that still work with the CSLNode. The inserter may link
+		/// higher lvls after the CSLNode is removed, so the last one of them unlinks it again and retires it
+		std::atomic<int> users{ 2 };
+		/// @brief Pointers to the next CSLNodes on each lvl with the lowest bit as the deletion mark.
+		/// Allocated in the same block right after the node so it holds lvl + 1 pointers
+		std::atomic<uintptr_t> lvlCSLNodes[1];
+
+		/// @brief Constructor to set the value and lvl. Use create() so the pointers get allocated
+		CSLNode(const T& _value, int _lvl)
+			:value(_value), lvl(_lvl)
+		{
+			for (int i = 0; i < _lvl + 1; i++) {
+				new (&lvlCSLNodes[i]) std::atomic<uintptr_t>(0);
+			}
+		}
+
+		/// @brief Returns the size of the block that holds a CSLNode with given lvl
+		static size_t bytesFor(int _lvl) noexcept
+		{
+			return sizeof(CSLNode) + sizeof(std::atomic<uintptr_t>) * _lvl;
+		}
+
+		/// @brief Allocates one block for the CSLNode and its pointers and constructs it there
+		static CSLNode* create(const T& _value, int _lvl)
+		{
+			void* block = ::operator new(bytesFor(_lvl));//may throw
+			try {
+				return new (block) CSLNode(_value, _lvl);
+			}
+			catch (...) {
+				::operator delete(block);
+				throw;
+			}
+		}
+
+		/// @brief Destroys a CSLNode made with create() and frees its block
+		static void destroy(CSLNode* node) noexcept
+		{
+			node->~CSLNode();
+			::operator delete(node);
+		}
+	};
+
+	/// @brief A node that is unlinked and waits for no thread to see it
+	struct Retired
+	{
+		/// @brief The unlinked node
+		CSLNode* node;
+		/// @brief Global epoch at the time of unlinking
+		uint64_t epoch;
+	};
+
+	/// @brief Data of one thread for this list. Only its own thread changes it, except announce
+	struct alignas(64) ThreadSlot
+	{
+		/// @brief (epoch << 1) | 1 while the thread is working with the list, 0 when it is not
+		std::atomic<uint64_t> announce{ 0 };
+		/// @brief Number of nested guards of the thread
+		unsigned nest = 0;
+		/// @brief Generator of the random lvls for the thread's new nodes
+		XorShiftLevelGenerator levelGen;
+		/// @brief Nodes unlinked by the thread that are not freed yet
+		std::vector<Retired> retired;
+	};
+
+	/// @brief Keeps the calling thread announced in the current epoch while it exists.
+	/// Nodes that the thread can see are not freed before it is destroyed
+	class EpochGuard
+	{
+	private:
+		/// @brief Slot of the thread in the list
+		ThreadSlot* slot;
+	public:
+		/// @brief Announces the thread in the current epoch
+		EpochGuard(const ConcurrentSkipList& list);
+		/// @brief Announces the thread again, nested guards are allowed
+		EpochGuard(const EpochGuard& other) noexcept;
+		/// @brief Guards are not reassigned
+		EpochGuard& operator=(const EpochGuard&) = delete;
+		/// @brief Ends the announcement if this is the last guard of the thread
+		~EpochGuard() noexcept;
+	};
+
+	//data
+	/// @brief The level that is expected to be the maximum useful such as log2(32GB) can store its elements
+	static const short MAX_POSSIBLE_LVL = 35;
+	/// @brief Retired nodes of a thread after which it tries to free some
+	static const size_t RETIRE_BATCH = 64;
+	/// @brief Mark bit in the next pointers
+	static const uintptr_t MARK = 1;
+
+	/// @brief Pointer to the first header CSLNode
+	CSLNode* first = nullptr;
+	/// @brief Maximum level that the list can have
+	size_t MAXLVL;
+	/// @brief Fraction of the CSLNodes with level X pointers that also have next level pointers.
+	double fraction;
+	/// @brief Number of inserted and not removed CSLNodes
+	std::atomic<size_t> size{ 0 };
+	/// @brief Bytes of the CSLNodes that are not freed yet (inserted or waiting to be freed)
+	std::atomic<size_t> nodesBytes{ 0 };
+	/// @brief Bytes of the retired lists of all threads. Kept here as other threads' vectors can not be read safely
+	std::atomic<size_t> retiredBytes{ 0 };
+	/// @brief Global epoch for the reclamation
+	mutable std::atomic<uint64_t> epoch{ 2 };
+	/// @brief Data of every thread. Indexed with concurrentThreadIndex()
+	mutable ThreadSlot slots[CSL_MAX_THREADS];
+
+	//private methods
+	/// @brief Returns the pointer without the mark bit
+	static CSLNode* unmarked(uintptr_t word) noexcept { return reinterpret_cast<CSLNode*>(word & ~MARK); }
+	/// @brief Returns if the mark bit is set
+	static bool isMarked(uintptr_t word) noexcept { return (word & MARK) != 0; }
+	/// @brief Returns if two values are equal using only operator<
+	static bool isEqual(const T& a, const T& b) noexcept { return !(a < b) && !(b < a); }
+	/// @brief Returns the slot of the calling thread
+	ThreadSlot& mySlot() const { return slots[concurrentThreadIndex()]; }
+	/// @brief Searches the place of a value on all levels and unlinks the marked CSLNodes on the way.
+	/// @param preds Filled with the last CSLNode before the value on each level
+	/// @param succs Filled with the first CSLNode not less than the value on each level
+	/// @return If an unmarked CSLNode with such value is found (it is succs[0])
+	bool find(const T& val, CSLNode** preds, CSLNode** succs) noexcept;
+	/// @brief Returns the first CSLNode not less than the value that was not removed when it was passed,
+	/// stepping over marked CSLNodes without unlinking them. The caller must hold an EpochGuard
+	CSLNode* firstNotLess(const T& val) const noexcept;
+	/// @brief Keeps an unlinked CSLNode until no thread can see it
+	void retire(CSLNode* node);
+	/// @brief Called by the inserter and by the remover of a CSLNode when they do not link or unlink it anymore.
+	/// The last one of them unlinks it from all lvls and retires it, so it is not linked again after that
+	void release(CSLNode* node, const T& val);
+	/// @brief Moves the global epoch forward if all working threads are in it
+	void tryAdvance() noexcept;
+	/// @brief Frees the retired CSLNodes of a slot that no thread can see
+	void freeRetired(ThreadSlot& slot) noexcept;
+
+public:
+	friend class CSListIterator<T>;
+	//constructors and operators
+	/// @brief Constructor to create a list with specific MAXLVL and fraction.
+	/// @param seed Seed for the lvl generators. Each thread gets it mixed with its index
+	ConcurrentSkipList(const size_t maxLvl, const double fraction, const uint64_t seed = XorShiftLevelGenerator::DEFAULT_SEED);
+	/// @brief The list is shared between threads and is not copied or moved
+	ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+	/// @brief The list is shared between threads and is not copied or moved
+	ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+	/// @brief Destructor to delete all data. No other thread may use the list at that time
+	~ConcurrentSkipList() noexcept;
+	//Public methods
+	/// @brief Creates a new CSLNode with a random lvl and places it in sorted order. Thread-safe
+	/// @param val Value to be given to the new CSLNode. No repetitions allowed.
+	/// @return True if CSLNode was created and inserted. Else false
+	bool insert(const T& val);
+	/// @brief Removes a specific CSLNode with given value if found. Thread-safe
+	/// @param val Value to be removed
+	/// @return True If CSLNode was found and removed by this call.
+	bool remove(const T& val);
+	/// @brief Returns If a CSLNode with given value exists in the list. Thread-safe
+	/// @param val Searched value
+	bool exists(const T& val) const;
+	/// @brief Calls f(value) in ascending order for the values in [lo, hi) that are not removed when they are passed. Thread-safe.
+	/// Values inserted or removed during the call may or may not be visited
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const;
+	/// @brief Number of currently inserted CSLNodes. Exact only when no other thread changes the list
+	size_t getSize() const noexcept;
+	//iteration
+	/// @brief Returns iterator to the start (head) of the list. The nodes it can reach
+	/// are not freed while the iterator exists
+	CSListIterator<T> begin() const;
+	/// @brief Returns iterator to the end (nullptr) of the list
+	CSListIterator<T> end() const noexcept;
+	/// @brief Returns how many bytes are used by the structure atm
+	size_t getBytesUsed() const noexcept;
+};
+
+/// @brief Concurrent Skip List iterator that goes through lvl 0 elements and skips the removed ones.
+/// Keeps the thread announced so the nodes it points to are not freed
+template <class T>
+class CSListIterator {
+private:
+	//data
+	/// @brief Guard of the thread. Null for the end iterator
+	typename ConcurrentSkipList<T>::EpochGuard* guard = nullptr;
+	/// @brief Current CSLNode in the list.
+	typename ConcurrentSkipList<T>::CSLNode* current = nullptr;
+	//methods
+	/// @brief Constructor that starts from the header's next CSLNode
+	CSListIterator(const ConcurrentSkipList<T>* list);
+	/// @brief Constructor for the end iterator
+	CSListIterator() noexcept = default;
+	/// @brief Moves current to the first not removed CSLNode starting from it
+	void skipRemoved() noexcept;
+public:
+	friend class ConcurrentSkipList<T>;
+	//constructors and operators
+	/// @brief Copy constructor. The copy has its own guard
+	CSListIterator(const CSListIterator& other);
+	/// @brief Copy operator. The copy has its own guard
+	CSListIterator& operator=(const CSListIterator& other);
+	/// @brief Destructor. Ends the guard
+	~CSListIterator() noexcept;
+	//methods
+	/// @brief Operator to move to the next not removed CSLNode in the order.
+	CSListIterator<T>& operator++();
+	/// @brief Operator to get the current CSLNode
+	const typename ConcurrentSkipList<T>::CSLNode* operator*() const;
+	/// @brief Operator to check if two Iterators are the same
+	bool operator==(const CSListIterator& other) const noexcept;
+	/// @brief Operator to check if two Iterators are not the same
+	bool operator!=(const CSListIterator& other) const noexcept;
+};
+
+//impl
+
+template <class T>
+ConcurrentSkipList<T>::EpochGuard::EpochGuard(const ConcurrentSkipList<T>& list)
+	: slot(&list.mySlot())
+{
+	if (slot->nest++ > 0) return;
+	//announce until the epoch does not change in between, so no advance can miss it
+	uint64_t e = list.epoch.load();
+	while (true) {
+		slot->announce.store((e << 1) | 1);
+		uint64_t now = list.epoch.load();
+		if (now == e) break;
+		e = now;
+	}
+}
+
+template <class T>
+ConcurrentSkipList<T>::EpochGuard::EpochGuard(const EpochGuard& other) noexcept
+	: slot(other.slot)
+{
+	++slot->nest;
+}
+
+template <class T>
+ConcurrentSkipList<T>::EpochGuard::~EpochGuard() noexcept
+{
+	if (--slot->nest == 0) {
+		slot->announce.store(0);
+	}
+}
+
+template <class T>
+ConcurrentSkipList<T>::ConcurrentSkipList(const size_t maxLvl, const double _fraction, const uint64_t seed)
+	: MAXLVL(maxLvl), fraction(_fraction)
+{
+	if (fraction < 0 || fraction >= 1) fraction = 0.5;
+	if (MAXLVL == 0) MAXLVL = 3;
+	else if (MAXLVL > MAX_POSSIBLE_LVL) MAXLVL = MAX_POSSIBLE_LVL;
+	for (int i = 0; i < CSL_MAX_THREADS; i++) {
+		slots[i].levelGen.seed(seed ^ (0x9E3779B97F4A7C15ull * (i + 1)));
+		slots[i].levelGen.setFraction(fraction);
+	}
+	first = CSLNode::create(T(), (int)MAXLVL);
+}
+//header CSLNode is set as starting only and his value is not used
+
+template <class T>
+ConcurrentSkipList<T>::~ConcurrentSkipList() noexcept
+{
+	if (!first) return;
+	//removed nodes are unlinked before they are retired, so lvl 0 has only the others
+	CSLNode* cur = unmarked(first->lvlCSLNodes[0].load());
+	while (cur) {
+		CSLNode* next = unmarked(cur->lvlCSLNodes[0].load());
+		CSLNode::destroy(cur);
+		cur = next;
+	}
+	CSLNode::destroy(first);
+	first = nullptr;
+	for (int i = 0; i < CSL_MAX_THREADS; i++) {
+		for (const Retired& r : slots[i].retired) {
+			CSLNode::destroy(r.node);
+		}
+		slots[i].retired.clear();
+	}
+}
+
+template <class T>
+bool ConcurrentSkipList<T>::find(const T& val, CSLNode** preds, CSLNode** succs) noexcept
+{
+retry:
+	CSLNode* pred = first;
+	CSLNode* cur = nullptr;
+	for (int i = (int)MAXLVL; i >= 0; i--) {
+		cur = unmarked(pred->lvlCSLNodes[i].load());
+		while (cur) {
+			uintptr_t next = cur->lvlCSLNodes[i].load();
+			//unlink the marked CSLNodes between pred and the next unmarked one
+			while (isMarked(next)) {
+				uintptr_t expected = reinterpret_cast<uintptr_t>(cur);
+				if (!pred->lvlCSLNodes[i].compare_exchange_strong(expected, next & ~MARK)) {
+					goto retry;
+				}
+				cur = unmarked(next);
+				if (!cur) break;
+				next = cur->lvlCSLNodes[i].load();
+			}
+			if (cur && cur->value < val) {
+				pred = cur;
+				cur = unmarked(next);
+			}
+			else break;
+		}
+		preds[i] = pred;
+		succs[i] = cur;
+	}
+	return cur && isEqual(cur->value, val);
+}
+
+template <class T>
+bool ConcurrentSkipList<T>::insert(const T& val)
+{
+	EpochGuard guard(*this);
+	CSLNode* preds[MAX_POSSIBLE_LVL + 1];
+	CSLNode* succs[MAX_POSSIBLE_LVL + 1];
+	int rlevel = (int)mySlot().levelGen(MAXLVL);
+	CSLNode* n = nullptr;
+	while (true) {
+		if (find(val, preds, succs)) {
+			if (n) CSLNode::destroy(n); //was never visible to other threads
+			return false; //no dublication allowed
+		}
+		if (!n) n = CSLNode::create(val, rlevel);//ok to throw
+		for (int i = 0; i <= rlevel; i++) {
+			n->lvlCSLNodes[i].store(reinterpret_cast<uintptr_t>(succs[i]));
+		}
+		//linking on lvl 0 makes it part of the list
+		uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+		if (preds[0]->lvlCSLNodes[0].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(n))) {
+			break;
+		}
+	}
+	size.fetch_add(1);
+	nodesBytes.fetch_add(CSLNode::bytesFor(rlevel));
+
+	//higher lvls are only shortcuts and are linked one by one
+	bool removed = false;
+	for (int i = 1; i <= rlevel && !removed; i++) {
+		while (true) {
+			uintptr_t next = n->lvlCSLNodes[i].load();
+			if (isMarked(next)) { //removed meanwhile, no need of more lvls
+				removed = true;
+				break;
+			}
+			uintptr_t succ = reinterpret_cast<uintptr_t>(succs[i]);
+			if (next != succ && !n->lvlCSLNodes[i].compare_exchange_strong(next, succ)) {
+				continue; //got marked
+			}
+			uintptr_t expected = succ;
+			if (preds[i]->lvlCSLNodes[i].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(n))) {
+				break;
+			}
+			//the place changed, search again
+			if (!find(val, preds, succs) || succs[0] != n) { //removed meanwhile
+				removed = true;
+				break;
+			}
+		}
+		//it may be marked while linking, then release() unlinks it again
+		if (isMarked(n->lvlCSLNodes[i].load())) removed = true;
+	}
+	release(n, val);
+	return true;
+}
+
+template <class T>
+bool ConcurrentSkipList<T>::remove(const T& val)
+{
+	EpochGuard guard(*this);
+	CSLNode* preds[MAX_POSSIBLE_LVL + 1];
+	CSLNode* succs[MAX_POSSIBLE_LVL + 1];
+	if (!find(val, preds, succs)) return false; //not found
+	CSLNode* target = succs[0];
+	//mark the higher lvls first so no new links are made
+	for (int i = target->lvl; i >= 1; i--) {
+		uintptr_t next = target->lvlCSLNodes[i].load();
+		while (!isMarked(next)) {
+			target->lvlCSLNodes[i].compare_exchange_strong(next, next | MARK);
+		}
+	}
+	//the thread that marks lvl 0 is the one that removes it
+	uintptr_t next = target->lvlCSLNodes[0].load();
+	while (true) {
+		if (isMarked(next)) return false; //removed by other thread
+		if (target->lvlCSLNodes[0].compare_exchange_strong(next, next | MARK)) break;
+	}
+	size.fetch_sub(1);
+	release(target, val); //unlinks it from all lvls when the inserter is done with it
+	return true;
+}
+
+template <class T>
+typename ConcurrentSkipList<T>::CSLNode* ConcurrentSkipList<T>::firstNotLess(const T& val) const noexcept
+{
+	CSLNode* pred = first;
+	CSLNode* cur = nullptr;
+	for (int i = (int)MAXLVL; i >= 0; i--) {
+		cur = unmarked(pred->lvlCSLNodes[i].load());
+		while (cur) {
+			uintptr_t next = cur->lvlCSLNodes[i].load();
+			//step over the marked CSLNodes without unlinking them
+			while (isMarked(next)) {
+				cur = unmarked(next);
+				if (!cur) break;
+				next = cur->lvlCSLNodes[i].load();
+			}
+			if (cur && cur->value < val) {
+				pred = cur;
+				cur = unmarked(next);
+			}
+			else break;
+		}
+	}
+	return cur;
+}
+
+template <class T>
+bool ConcurrentSkipList<T>::exists(const T& val) const
+{
+	EpochGuard guard(*this);
+	CSLNode* cur = firstNotLess(val);
+	return cur && isEqual(cur->value, val) && !isMarked(cur->lvlCSLNodes[0].load());
+}
+
+template <class T>
+template <class F>
+void ConcurrentSkipList<T>::forEachInRange(const T& lo, const T& hi, F f) const
+{
+	EpochGuard guard(*this);
+	for (CSLNode* cur = firstNotLess(lo); cur && cur->value < hi; ) {
+		uintptr_t next = cur->lvlCSLNodes[0].load();
+		if (!isMarked(next)) f(cur->value);
+		cur = unmarked(next);
+	}
+}
+
+template <class T>
+void ConcurrentSkipList<T>::retire(CSLNode* node)
+{
+	ThreadSlot& slot = mySlot();
+	size_t capacity = slot.retired.capacity();
+	slot.retired.push_back({ node, epoch.load() });//may throw
+	retiredBytes.fetch_add((slot.retired.capacity() - capacity) * sizeof(Retired));
+	if (slot.retired.size() % RETIRE_BATCH == 0) {
+		tryAdvance();
+		freeRetired(slot);
+	}
+}
+
+template <class T>
+void ConcurrentSkipList<T>::release(CSLNode* node, const T& val)
+{
+	if (node->users.fetch_sub(1) != 1) return; //the other one is still working with it
+	//only a removed CSLNode gets here, as its remover is one of the two
+	CSLNode* preds[MAX_POSSIBLE_LVL + 1];
+	CSLNode* succs[MAX_POSSIBLE_LVL + 1];
+	find(val, preds, succs); //unlinks it from all lvls
+	retire(node);
+}
+
+template <class T>
+void ConcurrentSkipList<T>::tryAdvance() noexcept
+{
+	uint64_t e = epoch.load();
+	for (int i = 0; i < CSL_MAX_THREADS; i++) {
+		uint64_t a = slots[i].announce.load();
+		if ((a & 1) && (a >> 1) != e) return; //a thread is still in an older epoch
+	}
+	epoch.compare_exchange_strong(e, e + 1);
+}
+
+template <class T>
+void ConcurrentSkipList<T>::freeRetired(ThreadSlot& slot) noexcept
+{
+	//a node unlinked in epoch e can be seen only by threads announced in e or e - 1
+	uint64_t e = epoch.load();
+	size_t kept = 0;
+	for (size_t i = 0; i < slot.retired.size(); i++) {
+		if (slot.retired[i].epoch + 2 <= e) {
+			nodesBytes.fetch_sub(CSLNode::bytesFor(slot.retired[i].node->lvl));
+			CSLNode::destroy(slot.retired[i].node);
+		}
+		else {
+			slot.retired[kept++] = slot.retired[i];
+		}
+	}
+	slot.retired.resize(kept);
+}
+
+template <class T>
+size_t ConcurrentSkipList<T>::getSize() const noexcept
+{
+	return size.load();
+}
+
+template <class T>
+CSListIterator<T> ConcurrentSkipList<T>::begin() const
+{
+	return CSListIterator<T>(this);
+}
+
+template <class T>
+CSListIterator<T> ConcurrentSkipList<T>::end() const noexcept
+{
+	return CSListIterator<T>();
+}
+
+template <class T>
+size_t ConcurrentSkipList<T>::getBytesUsed() const noexcept
+{
+	return sizeof(ConcurrentSkipList<T>) + CSLNode::bytesFor(first ? first->lvl : 0) + nodesBytes.load() + retiredBytes.load();
+}
+
+//iter
+template <class T>
+CSListIterator<T>::CSListIterator(const ConcurrentSkipList<T>* list)
+	: guard(new typename ConcurrentSkipList<T>::EpochGuard(*list))
+{
+	current = ConcurrentSkipList<T>::unmarked(list->first->lvlCSLNodes[0].load());
+	skipRemoved();
+}
+
+template <class T>
+CSListIterator<T>::CSListIterator(const CSListIterator<T>& other)
+	: guard(other.guard ? new typename ConcurrentSkipList<T>::EpochGuard(*other.guard) : nullptr), current(other.current) {}
+
+template <class T>
+CSListIterator<T>& CSListIterator<T>::operator=(const CSListIterator<T>& other)
+{
+	if (&other != this) {
+		CSListIterator<T> copy(other);
+		std::swap(guard, copy.guard);
+		std::swap(current, copy.current);
+	}
+	return *this;
+}
+
+template <class T>
+CSListIterator<T>::~CSListIterator() noexcept
+{
+	delete guard;
+}
+
+template <class T>
+void CSListIterator<T>::skipRemoved() noexcept
+{
+	while (current && ConcurrentSkipList<T>::isMarked(current->lvlCSLNodes[0].load())) {
+		current = ConcurrentSkipList<T>::unmarked(current->lvlCSLNodes[0].load());
+	}
+}
+
+template <class T>
+CSListIterator<T>& CSListIterator<T>::operator++()
+{
+	if (current) {
+		current = ConcurrentSkipList<T>::unmarked(current->lvlCSLNodes[0].load());
+		skipRemoved();
+	}
+	return *this;
+}
+
+template <class T>
+const typename ConcurrentSkipList<T>::CSLNode* CSListIterator<T>::operator*() const
+{
+	return current;
+}
+
+template <class T>
+bool CSListIterator<T>::operator==(const CSListIterator<T>& other) const noexcept {
+	return current == other.current;
+}
+
+template <class T>
+bool CSListIterator<T>::operator!=(const CSListIterator<T>& other) const noexcept {
+	return current != other.current;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// @brief Returns the index of the highest set bit. 0 for 0
+inline int highestBit(uint64_t x) noexcept
+{
+	if (!x) return 0;
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanReverse(&index, (unsigned long)(x >> 32))) return 32 + (int)index;
+	_BitScanReverse(&index, (unsigned long)x);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(x);
+#endif
+}
+
+/// @brief Log-linear latency histogram (HDR style).
+/// Values below 2^SUB_BITS have their own buckets. Bigger values go to one of 2^SUB_BITS buckets
+/// for their power of two, so a bucket is never wider than 1/2^SUB_BITS (about 3%) of its values.
+/// Recording is a few instructions and no allocation, so it can be done for every operation
+class LatencyHistogram {
+private:
+	/// @brief Bits of a value kept below its highest bit
+	static const int SUB_BITS = 5;
+	/// @brief Buckets for each power of two
+	static const int SUB_CNT = 1 << SUB_BITS;
+	/// @brief Total number of buckets: the exact ones and SUB_CNT for each bigger power of two
+	static const int BUCKET_CNT = SUB_CNT + (64 - SUB_BITS) * SUB_CNT;
+
+	//data
+	/// @brief Number of values in each bucket
+	uint64_t counts[BUCKET_CNT];
+	/// @brief Number of recorded values
+	uint64_t total = 0;
+	/// @brief Sum of the recorded values, for the mean
+	double sum = 0;
+	/// @brief Smallest recorded value
+	uint64_t minValue = UINT64_MAX;
+	/// @brief Biggest recorded value
+	uint64_t maxValue = 0;
+
+	//private methods
+	/// @brief Returns the bucket of a value
+	static int bucketOf(uint64_t value) noexcept
+	{
+		if (value < SUB_CNT) return (int)value;
+		int shift = highestBit(value) - SUB_BITS;
+		return SUB_CNT + shift * SUB_CNT + (int)((value >> shift) - SUB_CNT);
+	}
+	/// @brief Returns the biggest value that goes to a bucket
+	static uint64_t highestIn(int bucket) noexcept
+	{
+		if (bucket < SUB_CNT) return bucket;
+		int shift = (bucket - SUB_CNT) / SUB_CNT;
+		uint64_t sub = (uint64_t)((bucket - SUB_CNT) % SUB_CNT + SUB_CNT);
+		return ((sub + 1) << shift) - 1;
+	}
+public:
+	/// @brief Standart constructor creating empty histogram
+	LatencyHistogram() noexcept
+	{
+		clear();
+	}
+	/// @brief Adds one value
+	void record(uint64_t value) noexcept
+	{
+		++counts[bucketOf(value)];
+		++total;
+		sum += (double)value;
+		if (value < minValue) minValue = value;
+		if (value > maxValue) maxValue = value;
+	}
+	/// @brief Adds all values of another histogram
+	void merge(const LatencyHistogram& other) noexcept
+	{
+		for (int i = 0; i < BUCKET_CNT; i++) {
+			counts[i] += other.counts[i];
+		}
+		total += other.total;
+		sum += other.sum;
+		if (other.minValue < minValue) minValue = other.minValue;
+		if (other.maxValue > maxValue) maxValue = other.maxValue;
+	}
+	/// @brief Removes all values
+	void clear() noexcept
+	{
+		std::memset(counts, 0, sizeof(counts));
+		total = 0;
+		sum = 0;
+		minValue = UINT64_MAX;
+		maxValue = 0;
+	}
+	/// @brief Returns the value that percent% of the values are not bigger than (with the bucket precision).
+	/// 0 for an empty histogram
+	uint64_t valueAtPercentile(double percent) const noexcept
+	{
+		if (!total) return 0;
+		if (percent >= 100) return maxValue;
+		uint64_t needed = (uint64_t)(percent / 100 * (double)total + 0.5);
+		if (needed < 1) needed = 1;
+		uint64_t seen = 0;
+		for (int i = 0; i < BUCKET_CNT; i++) {
+			seen += counts[i];
+			if (seen >= needed) {
+				uint64_t value = highestIn(i);
+				return value < maxValue ? value : maxValue;
+			}
+		}
+		return maxValue;
+	}
+	/// @brief Returns the number of recorded values
+	uint64_t getCount() const noexcept { return total; }
+	/// @brief Returns the average of the recorded values. 0 for an empty histogram
+	double getMean() const noexcept { return total ? sum / (double)total : 0; }
+	/// @brief Returns the smallest recorded value. 0 for an empty histogram
+	uint64_t getMin() const noexcept { return total ? minValue : 0; }
+	/// @brief Returns the biggest recorded value
+	uint64_t getMax() const noexcept { return maxValue; }
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// @brief Returns the number of zero bits before the lowest set bit. 64 for 0
+inline int countTrailingZeros(uint64_t x) noexcept
+{
+	if (!x) return 64;
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)x)) return (int)index;
+	_BitScanForward(&index, (unsigned long)(x >> 32));
+	return 32 + (int)index;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+/// @brief Level generator policy for the skip list using a xorshift64* generator.
+/// When the fraction is a power of 1/2 the whole level comes from the trailing zeros of one 64-bit draw.
+/// All level generators have the same surface: seed, setFraction and operator()
+class XorShiftLevelGenerator {
+private:
+	//data
+	/// @brief Generator state. Never 0
+	uint64_t state;
+	/// @brief Number of random bits per level when the fraction is 1/2^bitsPerLvl. 0 for other fractions
+	int bitsPerLvl = 1;
+	/// @brief Fraction scaled to 2^64, used for fractions that are not powers of 1/2
+	uint64_t threshold = 1ull << 63;
+
+	//private methods
+	/// @brief Returns the next 64 random bits
+	uint64_t next() noexcept
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+public:
+	/// @brief Seed that is used when none is given. Same seed gives the same levels
+	static const uint64_t DEFAULT_SEED = 0x9E3779B97F4A7C15ull;
+
+	/// @brief Constructor that sets the seed
+	explicit XorShiftLevelGenerator(uint64_t seedValue = DEFAULT_SEED) noexcept
+	{
+		seed(seedValue);
+	}
+	/// @brief Restarts the generator from a seed
+	void seed(uint64_t seedValue) noexcept
+	{
+		state = seedValue ? seedValue : DEFAULT_SEED;
+	}
+	/// @brief Sets the fraction of the nodes on a lvl that also go to the next lvl
+	void setFraction(double fraction) noexcept
+	{
+		bitsPerLvl = 0;
+		for (int bits = 1; bits < 64; bits++) {
+			if (fraction == 1.0 / (double)(1ull << bits)) {
+				bitsPerLvl = bits;
+				break;
+			}
+		}
+		threshold = (uint64_t)(fraction * 18446744073709551616.0);
+	}
+	/// @brief Returns a random lvl from 0 to maxLvl
+	size_t operator()(size_t maxLvl) noexcept
+	{
+		if (bitsPerLvl) {
+			size_t randLvl = countTrailingZeros(next()) / bitsPerLvl;
+			return randLvl < maxLvl ? randLvl : maxLvl;
+		}
+		size_t randLvl = 0;
+		while (randLvl < maxLvl && next() < threshold) {
+			randLvl++;
+		}
+		return randLvl;
+	}
+};
+
+/// @brief Level generator policy that uses rand() like the first versions of the skip list.
+/// Kept for comparison. Seeding it seeds the global rand() state
+class RandLevelGenerator {
+private:
+	//data
+	/// @brief Fraction of the nodes on a lvl that also go to the next lvl
+	double fraction = 0.5;
+public:
+	/// @brief Constructor that does not touch the global state
+	RandLevelGenerator() noexcept = default;
+	/// @brief Constructor that seeds rand()
+	explicit RandLevelGenerator(uint64_t seedValue) noexcept
+	{
+		seed(seedValue);
+	}
+	/// @brief Seeds rand()
+	void seed(uint64_t seedValue) noexcept
+	{
+		srand((unsigned)seedValue);
+	}
+	/// @brief Sets the fraction of the nodes on a lvl that also go to the next lvl
+	void setFraction(double _fraction) noexcept
+	{
+		fraction = _fraction;
+	}
+	/// @brief Returns a random lvl from 0 to maxLvl
+	size_t operator()(size_t maxLvl) noexcept
+	{
+		double r = (double)rand() / RAND_MAX;
+		size_t randLvl = 0;
+		while (r < fraction && randLvl < maxLvl)
+		{
+			randLvl++;
+			r = (double)rand() / RAND_MAX;
+		}
+		return randLvl;
+	}
+};
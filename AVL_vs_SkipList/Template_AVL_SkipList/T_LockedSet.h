@@ -0,0 +1,203 @@
+#pragma once
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+/// @brief Makes a structure that is not thread-safe usable from many threads with one mutex for every operation.
+/// Has the same surface as the wrapped structure for insert, remove, exists, forEachInRange and buildFromSorted
+template <class Set>
+class MutexLockedSet {
+private:
+	//data
+	mutable std::mutex lock;
+	Set set;
+public:
+	/// @brief Constructor that gives its arguments to the wrapped structure
+	template <class... Args>
+	explicit MutexLockedSet(Args&&... args)
+		: set(std::forward<Args>(args)...) {}
+	template <class K>
+	bool insert(const K& key)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return set.insert(key);
+	}
+	template <class K>
+	bool remove(const K& key)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return set.remove(key);
+	}
+	template <class K>
+	bool exists(const K& key) const
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return set.exists(key);
+	}
+	/// @brief The lock is held for the whole scan
+	template <class K, class F>
+	void forEachInRange(const K& lo, const K& hi, F f) const
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		set.forEachInRange(lo, hi, f);
+	}
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return set.buildFromSorted(first, last);
+	}
+	size_t getBytesUsed() const
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return sizeof(*this) - sizeof(Set) + set.getBytesUsed();
+	}
+};
+
+/// @brief Makes a structure that is not thread-safe usable from many threads with a reader-writer lock:
+/// searches and scans run together, inserts and removes run alone.
+/// The wrapped structure must not change anything in its const methods
+template <class Set>
+class SharedLockedSet {
+private:
+	//data
+	mutable std::shared_timed_mutex lock;
+	Set set;
+public:
+	/// @brief Constructor that gives its arguments to the wrapped structure
+	template <class... Args>
+	explicit SharedLockedSet(Args&&... args)
+		: set(std::forward<Args>(args)...) {}
+	template <class K>
+	bool insert(const K& key)
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(lock);
+		return set.insert(key);
+	}
+	template <class K>
+	bool remove(const K& key)
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(lock);
+		return set.remove(key);
+	}
+	template <class K>
+	bool exists(const K& key) const
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(lock);
+		return set.exists(key);
+	}
+	/// @brief The lock is held for the whole scan
+	template <class K, class F>
+	void forEachInRange(const K& lo, const K& hi, F f) const
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(lock);
+		set.forEachInRange(lo, hi, f);
+	}
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		std::lock_guard<std::shared_timed_mutex> guard(lock);
+		return set.buildFromSorted(first, last);
+	}
+	size_t getBytesUsed() const
+	{
+		std::shared_lock<std::shared_timed_mutex> guard(lock);
+		return sizeof(*this) - sizeof(Set) + set.getBytesUsed();
+	}
+};
+
+/// @brief Splits the keys by hash between SHARDS structures, each behind its own reader-writer lock,
+/// so operations on different shards do not wait for each other.
+/// A range scan goes through the shards one after another: values come in order inside each shard only
+template <class Set, size_t SHARDS = 16>
+class ShardedSet {
+private:
+	/// @brief One structure with its lock, on its own cache lines so the locks of different shards are not shared
+	struct alignas(64) Shard {
+		mutable std::shared_timed_mutex lock;
+		std::unique_ptr<Set> set;
+	};
+
+	//data
+	Shard shards[SHARDS];
+
+	//private methods
+	/// @brief Returns the shard of a key. Hashes are mixed so keys that are close spread over all shards
+	template <class K>
+	Shard& shardOf(const K& key) noexcept
+	{
+		return shards[(std::hash<K>()(key) * 0x9E3779B97F4A7C15ull >> 32) % SHARDS];
+	}
+	template <class K>
+	const Shard& shardOf(const K& key) const noexcept
+	{
+		return const_cast<ShardedSet*>(this)->shardOf(key);
+	}
+public:
+	/// @brief Constructor that gives its arguments to each of the wrapped structures
+	template <class... Args>
+	explicit ShardedSet(const Args&... args)
+	{
+		for (Shard& shard : shards) {
+			shard.set.reset(new Set(args...));
+		}
+	}
+	template <class K>
+	bool insert(const K& key)
+	{
+		Shard& shard = shardOf(key);
+		std::lock_guard<std::shared_timed_mutex> guard(shard.lock);
+		return shard.set->insert(key);
+	}
+	template <class K>
+	bool remove(const K& key)
+	{
+		Shard& shard = shardOf(key);
+		std::lock_guard<std::shared_timed_mutex> guard(shard.lock);
+		return shard.set->remove(key);
+	}
+	template <class K>
+	bool exists(const K& key) const
+	{
+		const Shard& shard = shardOf(key);
+		std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+		return shard.set->exists(key);
+	}
+	/// @brief Scans every shard under its own lock
+	template <class K, class F>
+	void forEachInRange(const K& lo, const K& hi, F f) const
+	{
+		for (const Shard& shard : shards) {
+			std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+			shard.set->forEachInRange(lo, hi, f);
+		}
+	}
+	/// @brief Splits the sorted values by shard (each part stays sorted) and bulk loads every shard
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		std::vector<std::vector<typename std::iterator_traits<It>::value_type>> parts(SHARDS);
+		for (It it = first; it != last; ++it) {
+			parts[&shardOf(*it) - shards].push_back(*it);
+		}
+		bool built = true;
+		for (size_t i = 0; i < SHARDS; i++) {
+			std::lock_guard<std::shared_timed_mutex> guard(shards[i].lock);
+			built = shards[i].set->buildFromSorted(parts[i].begin(), parts[i].end()) && built;
+		}
+		return built;
+	}
+	size_t getBytesUsed() const
+	{
+		size_t bytes = sizeof(*this);
+		for (const Shard& shard : shards) {
+			std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+			bytes += shard.set->getBytesUsed();
+		}
+		return bytes;
+	}
+};
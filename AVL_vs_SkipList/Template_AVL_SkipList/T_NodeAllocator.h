@@ -0,0 +1,269 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+/// @brief Node allocator policy that gives every node its own global new/delete call.
+/// All node allocators have the same surface: allocate, deallocate, release, adopt, getBytesUsed and swap
+class HeapAllocator {
+private:
+	//data
+	/// @brief Bytes of the blocks that are given and not yet deallocated
+	size_t used = 0;
+public:
+	/// @brief Blocks can not be freed all at once, every node has to be deallocated
+	static const bool BULK_RELEASE = false;
+	/// @brief Alignment that every block has
+	static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+	//constructors and operators
+	/// @brief Standart constructor
+	HeapAllocator() = default;
+	/// @brief Allocators are bound to the structure that uses them and are not copied
+	HeapAllocator(const HeapAllocator&) = delete;
+	/// @brief Allocators are bound to the structure that uses them and are not copied
+	HeapAllocator& operator=(const HeapAllocator&) = delete;
+	/// @brief Move constructor. Takes the other's counters
+	HeapAllocator(HeapAllocator&& other) noexcept { swap(other); }
+
+	//methods
+	/// @brief Returns a new block with given size. May throw std::bad_alloc
+	void* allocate(size_t bytes)
+	{
+		void* block = ::operator new(bytes);
+		used += bytes;
+		return block;
+	}
+	/// @brief Frees a block given by allocate with the same size
+	void deallocate(void* block, size_t bytes) noexcept
+	{
+		::operator delete(block);
+		used -= bytes;
+	}
+	/// @brief Nothing to free as blocks are deallocated one by one
+	void release() noexcept {}
+	/// @brief Takes all blocks of another allocator. They can be deallocated here after that
+	void adopt(HeapAllocator& other) noexcept
+	{
+		used += other.used;
+		other.used = 0;
+	}
+	/// @brief Returns the bytes given and not yet deallocated
+	size_t getBytesUsed() const noexcept
+	{
+		return used;
+	}
+	/// @brief Returns the bytes taken from the system. Same as the used ones
+	size_t getBytesReserved() const noexcept
+	{
+		return used;
+	}
+	/// @brief Exchanges the data of two allocators
+	void swap(HeapAllocator& other) noexcept
+	{
+		std::swap(used, other.used);
+	}
+};
+
+/// @brief Node allocator policy that cuts nodes from big contiguous chunks.
+/// Freed blocks go to a free list for their size class (multiple of GRANULE bytes) and are
+/// reused first. release() frees all chunks at once, so clearing a structure is O(chunks)
+/// @tparam CHUNK_BYTES Size of one chunk
+template <size_t CHUNK_BYTES = 64 * 1024>
+class SlabAllocator {
+private:
+	/// @brief Header at the start of every chunk and every big block
+	struct Chunk {
+		/// @brief Next chunk in the list
+		Chunk* next;
+		/// @brief Previous chunk in the list. Used only for the big blocks
+		Chunk* prev;
+	};
+	/// @brief Blocks are rounded up to a multiple of this size
+	static const size_t GRANULE = alignof(void*);
+	/// @brief Number of size classes. Bigger blocks get their own chunk
+	static const size_t CLASS_CNT = 64;
+	/// @brief Bytes reserved for the chunk header so the blocks after it stay aligned
+	static const size_t HEADER_BYTES = (sizeof(Chunk) + GRANULE - 1) / GRANULE * GRANULE;
+
+	static_assert(CHUNK_BYTES >= HEADER_BYTES + CLASS_CNT * GRANULE, "Chunk must fit the biggest size class");
+
+	//data
+	/// @brief Heads of the free lists for each size class. A free block keeps the next one in its first bytes
+	void* freeBlocks[CLASS_CNT] = {};
+	/// @brief List of all chunks
+	Chunk* chunks = nullptr;
+	/// @brief List of the blocks that were too big for a size class
+	Chunk* bigBlocks = nullptr;
+	/// @brief Next free byte in the current chunk
+	char* cur = nullptr;
+	/// @brief End of the current chunk
+	char* end = nullptr;
+	/// @brief Bytes of the blocks that are given and not yet deallocated
+	size_t used = 0;
+	/// @brief Bytes taken from the system for chunks and big blocks
+	size_t reserved = 0;
+
+	//private methods
+	/// @brief Returns the size class for given bytes. 0 is for the empty block
+	static size_t classOf(size_t bytes) noexcept
+	{
+		return (bytes + GRANULE - 1) / GRANULE;
+	}
+	/// @brief Starts a new chunk. May throw std::bad_alloc
+	void addChunk()
+	{
+		Chunk* chunk = static_cast<Chunk*>(::operator new(CHUNK_BYTES));
+		chunk->next = chunks;
+		chunk->prev = nullptr;
+		chunks = chunk;
+		cur = reinterpret_cast<char*>(chunk) + HEADER_BYTES;
+		end = reinterpret_cast<char*>(chunk) + CHUNK_BYTES;
+		reserved += CHUNK_BYTES;
+	}
+	/// @brief Puts the list tail after the list head and returns the joined list
+	static Chunk* join(Chunk* head, Chunk* tail) noexcept
+	{
+		if (!head) return tail;
+		Chunk* last = head;
+		while (last->next) last = last->next;
+		last->next = tail;
+		if (tail) tail->prev = last;
+		return head;
+	}
+	/// @brief Frees all chunks in a list
+	static void freeList(Chunk* list) noexcept
+	{
+		while (list) {
+			Chunk* next = list->next;
+			::operator delete(list);
+			list = next;
+		}
+	}
+public:
+	/// @brief All blocks can be freed at once with release()
+	static const bool BULK_RELEASE = true;
+	/// @brief Alignment that every block has
+	static const size_t ALIGNMENT = GRANULE;
+
+	//constructors and operators
+	/// @brief Standart constructor. No memory is taken before the first allocation
+	SlabAllocator() = default;
+	/// @brief Allocators are bound to the structure that uses them and are not copied
+	SlabAllocator(const SlabAllocator&) = delete;
+	/// @brief Allocators are bound to the structure that uses them and are not copied
+	SlabAllocator& operator=(const SlabAllocator&) = delete;
+	/// @brief Move constructor. Takes the other's chunks
+	SlabAllocator(SlabAllocator&& other) noexcept { swap(other); }
+	/// @brief Destructor. Frees all chunks
+	~SlabAllocator() noexcept { release(); }
+
+	//methods
+	/// @brief Returns a new block with given size. May throw std::bad_alloc
+	void* allocate(size_t bytes)
+	{
+		size_t cls = classOf(bytes);
+		if (cls >= CLASS_CNT) {
+			Chunk* block = static_cast<Chunk*>(::operator new(HEADER_BYTES + bytes));
+			block->prev = nullptr;
+			block->next = bigBlocks;
+			if (bigBlocks) bigBlocks->prev = block;
+			bigBlocks = block;
+			used += bytes;
+			reserved += HEADER_BYTES + bytes;
+			return reinterpret_cast<char*>(block) + HEADER_BYTES;
+		}
+		used += cls * GRANULE;
+		if (freeBlocks[cls]) {
+			void* block = freeBlocks[cls];
+			freeBlocks[cls] = *static_cast<void**>(block);
+			return block;
+		}
+		if (static_cast<size_t>(end - cur) < cls * GRANULE) {
+			try {
+				addChunk();
+			}
+			catch (...) {
+				used -= cls * GRANULE;
+				throw;
+			}
+		}
+		void* block = cur;
+		cur += cls * GRANULE;
+		return block;
+	}
+	/// @brief Returns a block given by allocate with the same size to its free list
+	void deallocate(void* block, size_t bytes) noexcept
+	{
+		size_t cls = classOf(bytes);
+		if (cls >= CLASS_CNT) {
+			Chunk* big = reinterpret_cast<Chunk*>(static_cast<char*>(block) - HEADER_BYTES);
+			if (big->prev) big->prev->next = big->next;
+			else bigBlocks = big->next;
+			if (big->next) big->next->prev = big->prev;
+			used -= bytes;
+			reserved -= HEADER_BYTES + bytes;
+			::operator delete(big);
+			return;
+		}
+		*static_cast<void**>(block) = freeBlocks[cls];
+		freeBlocks[cls] = block;
+		used -= cls * GRANULE;
+	}
+	/// @brief Frees all chunks at once. All given blocks become invalid
+	void release() noexcept
+	{
+		freeList(chunks);
+		freeList(bigBlocks);
+		chunks = bigBlocks = nullptr;
+		cur = end = nullptr;
+		std::memset(freeBlocks, 0, sizeof(freeBlocks));
+		used = reserved = 0;
+	}
+	/// @brief Takes all chunks, big blocks and free blocks of another allocator.
+	/// Its blocks can be deallocated here after that. The rest of its current chunk is not used any more
+	void adopt(SlabAllocator& other) noexcept
+	{
+		chunks = join(other.chunks, chunks);
+		bigBlocks = join(other.bigBlocks, bigBlocks);
+		for (size_t i = 0; i < CLASS_CNT; i++) {
+			void* block = other.freeBlocks[i];
+			if (!block) continue;
+			while (*static_cast<void**>(block)) {
+				block = *static_cast<void**>(block);
+			}
+			*static_cast<void**>(block) = freeBlocks[i];
+			freeBlocks[i] = other.freeBlocks[i];
+			other.freeBlocks[i] = nullptr;
+		}
+		used += other.used;
+		reserved += other.reserved;
+		other.chunks = other.bigBlocks = nullptr;
+		other.cur = other.end = nullptr;
+		other.used = other.reserved = 0;
+	}
+	/// @brief Returns the bytes given and not yet deallocated
+	size_t getBytesUsed() const noexcept
+	{
+		return used;
+	}
+	/// @brief Returns the bytes taken from the system
+	size_t getBytesReserved() const noexcept
+	{
+		return reserved;
+	}
+	/// @brief Exchanges the data of two allocators
+	void swap(SlabAllocator& other) noexcept
+	{
+		for (size_t i = 0; i < CLASS_CNT; i++) {
+			std::swap(freeBlocks[i], other.freeBlocks[i]);
+		}
+		std::swap(chunks, other.chunks);
+		std::swap(bigBlocks, other.bigBlocks);
+		std::swap(cur, other.cur);
+		std::swap(end, other.end);
+		std::swap(used, other.used);
+		std::swap(reserved, other.reserved);
+	}
+};
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PERF_COUNTERS_SUPPORTED 1
+#else
+#define PERF_COUNTERS_SUPPORTED 0
+#endif
+
+/// @brief Hardware performance counters of the calling thread (Linux perf_event_open, user space only).
+/// Every event is opened alone, so a missing one does not turn off the others. When the processor has fewer
+/// counters than events the kernel multiplexes them and the totals are scaled by the time each one really counted.
+/// Where counters are not supported or not allowed nothing is counted and has() is false
+class PerfCounters {
+public:
+	enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, EVENT_CNT };
+	/// @brief Totals of the events, indexed by Event
+	struct Counts {
+		uint64_t values[EVENT_CNT] = { 0 };
+		Counts& operator+=(const Counts& other) noexcept
+		{
+			for (int i = 0; i < EVENT_CNT; i++) {
+				values[i] += other.values[i];
+			}
+			return *this;
+		}
+	};
+private:
+	//data
+	/// @brief Descriptor of each event. -1 when it could not be opened
+	int fds[EVENT_CNT];
+	/// @brief Why the first event that failed could not be opened
+	std::string error;
+
+	//private methods
+#if PERF_COUNTERS_SUPPORTED
+	/// @brief Opens one disabled counter for the calling thread on any processor. Returns -1 on failure
+	static int open(uint32_t type, uint64_t config) noexcept
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+	/// @brief Returns the config of a read miss cache event
+	static uint64_t cacheReadMiss(uint64_t cache) noexcept
+	{
+		return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+#endif
+public:
+	/// @brief Opens all events it can. Counting starts with start()
+	PerfCounters()
+	{
+		for (int i = 0; i < EVENT_CNT; i++) {
+			fds[i] = -1;
+		}
+#if PERF_COUNTERS_SUPPORTED
+		const uint32_t types[EVENT_CNT] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+			PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE };
+		const uint64_t configs[EVENT_CNT] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+			cacheReadMiss(PERF_COUNT_HW_CACHE_L1D), cacheReadMiss(PERF_COUNT_HW_CACHE_LL),
+			cacheReadMiss(PERF_COUNT_HW_CACHE_DTLB), PERF_COUNT_HW_BRANCH_MISSES };
+		for (int i = 0; i < EVENT_CNT; i++) {
+			fds[i] = open(types[i], configs[i]);
+			if (fds[i] < 0 && error.empty()) {
+				error = std::string(name((Event)i)) + ": " + std::strerror(errno) +
+					(errno == EACCES || errno == EPERM ? " (see /proc/sys/kernel/perf_event_paranoid)" : "");
+			}
+		}
+#else
+		error = "hardware counters are read only on Linux";
+#endif
+	}
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	/// @brief Closes the events
+	~PerfCounters() noexcept
+	{
+#if PERF_COUNTERS_SUPPORTED
+		for (int fd : fds) {
+			if (fd >= 0) close(fd);
+		}
+#endif
+	}
+	/// @brief Returns if an event is counted
+	bool has(Event event) const noexcept { return fds[event] >= 0; }
+	/// @brief Returns if any event is counted
+	bool available() const noexcept
+	{
+		for (int fd : fds) {
+			if (fd >= 0) return true;
+		}
+		return false;
+	}
+	/// @brief Returns why an event is not counted. Empty if all are
+	const std::string& getError() const noexcept { return error; }
+	/// @brief Starts counting from 0
+	void start() noexcept
+	{
+#if PERF_COUNTERS_SUPPORTED
+		for (int fd : fds) {
+			if (fd < 0) continue;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+	/// @brief Stops counting and returns the counts since start(). 0 for events that are not counted
+	Counts stop() noexcept
+	{
+		Counts counts;
+#if PERF_COUNTERS_SUPPORTED
+		for (int fd : fds) {
+			if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+		for (int i = 0; i < EVENT_CNT; i++) {
+			//value, time enabled, time running
+			uint64_t data[3];
+			if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != (ssize_t)sizeof(data) || !data[2]) continue;
+			counts.values[i] = data[2] < data[1] ? (uint64_t)((double)data[0] * (double)data[1] / (double)data[2]) : data[0];
+		}
+#endif
+		return counts;
+	}
+	/// @brief Returns the short name of an event
+	static const char* name(Event event) noexcept
+	{
+		const char* names[EVENT_CNT] = { "cycles", "instructions", "L1d misses", "LLC misses", "dTLB misses", "branch misses" };
+		return names[event];
+	}
+};
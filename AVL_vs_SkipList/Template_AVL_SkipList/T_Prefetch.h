@@ -0,0 +1,17 @@
+#pragma once
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+/// @brief Asks the processor to start loading the cache line of an address that will be read soon.
+/// Does nothing where there is no such instruction. Never faults, so nullptr is fine
+inline void prefetchRead(const void* address) noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(address, 0, 3);
+#else
+	(void)address;
+#endif
+}
@@ -1,11 +1,22 @@
 #pragma once
+#include <exception>
+#include <future>
 #include <iostream>
-
-template <class T>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "T_NodeAllocator.h"
+#include "T_LevelGenerator.h"
+#include "T_Prefetch.h"
+
+template <class T, class Alloc = SlabAllocator<>, class LevelGen = XorShiftLevelGenerator>
 class SListIterator;
 
 /// @brief SkipList class with no repeating elements allowed
-template <class T>
+/// @tparam Alloc Node allocator policy (see T_NodeAllocator.h)
+/// @tparam LevelGen Random level generator policy (see T_LevelGenerator.h)
+template <class T, class Alloc = SlabAllocator<>, class LevelGen = XorShiftLevelGenerator>
 class SkipList
 {
 private:
@@ -14,44 +25,112 @@ private:
 	{
 		/// @brief SLNode's given value
 		T value;
-		/// @brief Array to hold pointers to SLNodes of different levels
-		SLNode** lvlSLNodes;
 		/// @brief The lvl of the SLNode - number of pointers that it has
 		const int lvl;
-		/// @brief Constructor to set the value and lvl
+		/// @brief Array to hold pointers to SLNodes of different levels.
+		/// Allocated in the same block right after the node so it holds lvl + 1 pointers.
+		/// The widths of lvls 1..lvl follow the pointers in the same block
+		SLNode* lvlSLNodes[1];
+
+		/// @brief Constructor to set the value and lvl. Use create() so the pointers get allocated
 		SLNode(const T& _value, int _lvl)
-			:value(_value), lvlSLNodes(new SLNode* [_lvl + 1]), lvl(_lvl)
+			:value(_value), lvl(_lvl)
 		{
 			//All lvls are set to nullptr at header
 			for (int i = 0; i < _lvl + 1; i++) {
 				lvlSLNodes[i] = nullptr;
 			}
+			for (int i = 1; i < _lvl + 1; i++) {
+				width(i) = 0;
+			}
 		}
 
-		///@brief Constructor to delete the SLNodes data
-		~SLNode() noexcept
+		/// @brief Returns the size of the block that holds a SLNode with given lvl.
+		/// Every lvl is its own size class
+		static size_t bytesFor(int _lvl) noexcept
 		{
-			delete[] lvlSLNodes;
-			lvlSLNodes = nullptr;
+			return sizeof(SLNode) + (sizeof(SLNode*) + sizeof(size_t)) * _lvl;
 		}
-		///@brief Returns the bytes used by this node atm
-		size_t getBytesUsed() {
-			size_t bytes = sizeof(SLNode);
-			if (bytes % alignof(SLNode) != 0) {
-				bytes = (bytes / alignof(SLNode) + 1) * alignof(SLNode);
+
+		/// @brief Returns the number of lvl 0 steps that the pointer on lvl i skips (i from 1 to lvl).
+		/// For a nullptr it is the number of SLNodes after this one.
+		/// Lvl 0 pointers always skip 1 SLNode so their widths are not kept
+		size_t& width(size_t i) noexcept
+		{
+			return reinterpret_cast<size_t*>(lvlSLNodes + lvl + 1)[i - 1];
+		}
+
+		/// @brief Returns the width of the pointer on lvl i including lvl 0
+		size_t span(size_t i) const noexcept
+		{
+			return i ? const_cast<SLNode*>(this)->width(i) : 1;
+		}
+
+		/// @brief Allocates one block for the SLNode and its pointers and constructs it there
+		/// @param allocator Node allocator policy object to take the block from
+		template <class A>
+		static SLNode* create(A& allocator, const T& _value, int _lvl)
+		{
+			void* block = allocator.allocate(bytesFor(_lvl));//may throw
+			try {
+				return new (block) SLNode(_value, _lvl);
 			}
-			return sizeof(SLNode) + sizeof(SLNode*) * (lvl + 1);
+			catch (...) {
+				allocator.deallocate(block, bytesFor(_lvl));
+				throw;
+			}
+		}
+
+		/// @brief Destroys a SLNode made with create() and gives its block back
+		template <class A>
+		static void destroy(A& allocator, SLNode* node) noexcept
+		{
+			size_t bytes = node->getBytesUsed();
+			node->~SLNode();
+			allocator.deallocate(node, bytes);
+		}
+
+		///@brief Returns the bytes used by this node atm
+		size_t getBytesUsed() const noexcept {
+			return bytesFor(lvl);
 		}
 
 	};
 
+	static_assert(alignof(SLNode*) == alignof(size_t), "Widths are kept right after the pointers");
+	static_assert(alignof(SLNode) <= Alloc::ALIGNMENT, "Allocator alignment is too small for the nodes");
 	//data
 	/// @brief The level that is expected to be the maximum useful such as log2(32GB) can store its elements
 	static const short MAX_POSSIBLE_LVL = 35;
+	/// @brief Number of searches that existsMany() keeps going at the same time
+	static const size_t LOOKUP_GROUP = 16;
+	/// @brief Lists with less SLNodes are copied by one thread
+	static const size_t PARALLEL_COPY_MIN = 1 << 16;
+	/// @brief Maximum number of threads that copy a list
+	static const unsigned MAX_COPY_TASKS = 16;
+
+	/// @brief Part of a list copied by one thread: its first and last SLNodes on each lvl
+	struct Segment
+	{
+		/// @brief First SLNode of the part on each lvl
+		SLNode* heads[MAX_POSSIBLE_LVL + 1] = {};
+		/// @brief Last SLNode of the part on each lvl
+		SLNode* tails[MAX_POSSIBLE_LVL + 1] = {};
+	};
 	/// @brief Pointers used for insertion and deletion level fixing
-	SLNode* update[MAX_POSSIBLE_LVL] = {};
+	SLNode* update[MAX_POSSIBLE_LVL + 1] = {};
+	/// @brief Positions of the update SLNodes (header is 0, the first element is 1)
+	size_t updatePos[MAX_POSSIBLE_LVL + 1] = {};
+	/// @brief Removed SLNodes kept for reuse, one list for each lvl.
+	/// The value of a kept SLNode is destroyed and its first bytes hold the next kept block
+	void* freeSLNodes[MAX_POSSIBLE_LVL + 1] = {};
 	/// @brief Pointer to the first header SLNode
 	SLNode* first = nullptr;
+	/// @brief Allocator that gives the memory for the header SLNode.
+	/// The header is kept out of the nodes' allocator so clearing can release all of its chunks
+	HeapAllocator headerAlloc;
+	/// @brief Allocator that gives the memory for the inserted SLNodes
+	Alloc alloc;
 
 	/// @brief Fraction of the SLNodes with level X pointers that also have next level pointers.
 	/// (1-fr) elements will be on lvl 1, (1-fr)^2 on lvl 2 and so on.
@@ -66,22 +145,52 @@ private:
 	/// @brief Number of SLNodes (without the header) that are inserted in the list.
 	size_t size = 0;
 
+	/// @brief Generator of the random lvls for the new SLNodes
+	LevelGen levelGen;
+
 	//private methods
-	/// @brief Returns a random integer value that is less than the MAXLVL
-	size_t randomLevel() const noexcept;
-	/// @brief Deletes all SLNodes. Sets size and lvl to 0. Do not delete the header SLNode
+	/// @brief Returns a random integer value that is not more than the MAXLVL
+	size_t randomLevel() noexcept;
+	/// @brief Returns a SLNode with given value and lvl. Reuses a removed one with the same lvl if there is such
+	SLNode* takeSLNode(const T& val, int _lvl);
+	/// @brief Destroys the value of a removed SLNode and keeps its block for reuse
+	void keepSLNode(SLNode* node) noexcept;
+	/// @brief Gives the blocks of all kept SLNodes back to the allocator
+	void releaseKept() noexcept;
+	/// @brief Deletes all SLNodes. Sets size and lvl to 0. Do not delete the header SLNode.
+	/// With a bulk releasing allocator the memory is freed by chunks instead of node by node
 	void clearAll() noexcept;
 	/// @brief Searches for a SLNode and returns it.
 	/// @param start The header pointer.
 	/// @param value Searched value.
 	SLNode* findSLNode(SLNode* start, const T& value) const noexcept;
+	/// @brief Returns the SLNode at position k (counting from 0). nullptr if k is not less than the size
+	SLNode* nodeAt(size_t k) const noexcept;
+	/// @brief Copies the SLNodes from from to to (not included) with the same lvls and widths.
+	/// Deletes the copied ones if an allocation fails
+	/// @param a Allocator for the new SLNodes
+	/// @param seg Filled with the first and last copied SLNodes on each lvl
+	static void cloneSegment(const SLNode* from, const SLNode* to, Alloc& a, Segment& seg);
+	/// @brief Deletes the SLNodes of a copied part
+	static void destroySegment(Alloc& a, Segment& seg) noexcept;
+	/// @brief Copies all SLNodes of other (must be empty). Big lists are split in parts by position
+	/// and each part is copied by its own thread and allocator, then the parts are linked
+	void copyFrom(const SkipList& other);
+	/// @brief Unlinks the SLNode after update[0] from all lvls and fixes the widths.
+	/// update has to hold the last SLNodes before it on every lvl
+	void unlinkSLNode(SLNode* current) noexcept;
+	/// @brief Returns the first SLNode with value not less than given one. nullptr if there is none
+	SLNode* firstNotLess(const T& value) const noexcept;
 
 public:
-	friend class SListIterator<T>;
+	friend class SListIterator<T, Alloc, LevelGen>;
 	//constructors and operators
 	/// @brief Constructor to create a list with specific MAXLVL and fraction.
 	SkipList(const size_t maxLvl, const double fraction);
-	/// @brief Copy constructor. Makes a copy and sets it as a header.
+	/// @brief Constructor to create a list with specific MAXLVL and fraction and
+	/// a seed for the lvl generator. Same seed and same operations give the same list
+	SkipList(const size_t maxLvl, const double fraction, const uint64_t seed);
+	/// @brief Copy constructor. Copies the SLNodes with the same lvls and widths in O(n). Uses copyFrom
 	/// @param other SkipList to be copied. No changes will be made on it.
 	SkipList(const SkipList& other);
 	/// @brief Move contrustor. Takes other's header and data.
@@ -107,15 +216,48 @@ public:
 	/// @brief Returns If a SLNode with given value exists in the list.
 	/// @param val Searched value
 	bool exists(const T& val) const noexcept;
+	/// @brief Checks many values at once. Keeps LOOKUP_GROUP searches going and moves each one step
+	/// in turn after prefetching its next SLNode, so the memory loads of different values overlap
+	/// @param vals Values to be searched
+	/// @param n Number of values
+	/// @param out Set to exists(vals[i]) for each i
+	void existsMany(const T* vals, size_t n, bool* out) const noexcept;
+	/// @brief Replaces the data with the values in [from, to) in one pass (O(n)) after a checking pass,
+	/// so It has to be a forward iterator. The values have to be in strictly ascending order.
+	/// Lvls come from the lvl generator as usual
+	/// @return False (and nothing is changed) if the values are not strictly ascending
+	template <class It>
+	bool buildFromSorted(It from, It to);
+	/// @brief Returns pointer to the smallest value not less than val. nullptr if there is none
+	const T* lowerBound(const T& val) const noexcept;
+	/// @brief Returns pointer to the smallest value greater than val. nullptr if there is none
+	const T* upperBound(const T& val) const noexcept;
+	/// @brief Calls f(value) for every value in [lo, hi) in ascending order.
+	/// Goes down to lo like a search and then walks lvl 0
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const;
+	/// @brief Returns pointer to the value at position k (counting from 0) in expected O(log n).
+	/// nullptr if k is not less than the size
+	const T* at(size_t k) const noexcept;
+	/// @brief Returns the position (counting from 0) of given value in expected O(log n).
+	/// getSize() if there is no such value
+	size_t indexOf(const T& val) const noexcept;
+	/// @brief Removes the SLNode at position k (counting from 0) in expected O(log n).
+	/// @return True if there was such position
+	bool eraseAt(size_t k) noexcept;
 	/// @brief Number of currently inserted SLNodes in the tree
 	size_t getSize() const noexcept;
 	/// @brief Method to delete all inserted SLNodes. Uses clearAll.
 	void clearData() noexcept;
+	/// @brief Restarts the lvl generator from a seed
+	void seed(const uint64_t seed) noexcept;
+	/// @brief Gives the memory of the removed SLNodes that are kept for reuse back to the allocator
+	void shrinkToFit() noexcept;
 	//iteration
 	/// @brief Returns iterator to the start (head) of the list
-	SListIterator<T> begin() const noexcept;
+	SListIterator<T, Alloc, LevelGen> begin() const noexcept;
 	/// @brief Returns iterator to the end (nullptr) of the tree
-	SListIterator<T> end() const noexcept;
+	SListIterator<T, Alloc, LevelGen> end() const noexcept;
 	/// @brief Returns how many bytes are used by the structure atm
 	size_t getBytesUsed() const noexcept;
 	/// @brief Prints on standart output values on all lvls on the list
@@ -123,22 +265,22 @@ public:
 };
 
 /// @brief Skip List iterator that goes through lvl 0 elements.
-template <class T>
+template <class T, class Alloc, class LevelGen>
 class SListIterator {
 private:
 	//data
 	/// @brief Current SLNode in the list.
-	typename SkipList<T>::SLNode* current = nullptr;
+	typename SkipList<T, Alloc, LevelGen>::SLNode* current = nullptr;
 	//methods
 	/// @brief Constructor that sets the SLNode as current
-	SListIterator(typename SkipList<T>::SLNode* head) noexcept;
+	SListIterator(typename SkipList<T, Alloc, LevelGen>::SLNode* head) noexcept;
 public:
-	friend class SkipList<T>;
+	friend class SkipList<T, Alloc, LevelGen>;
 	//methods
 	/// @brief Operator to move the stack to the next SLNode in the order.
-	SListIterator<T>  operator++();
+	SListIterator<T, Alloc, LevelGen>  operator++();
 	/// @brief Operator to get the next SLNode in the order
-	const typename SkipList<T>::SLNode* operator*() const;
+	const typename SkipList<T, Alloc, LevelGen>::SLNode* operator*() const;
 	/// @brief Operator to check if two Iterators are the same
 	bool operator==(const SListIterator& other) const noexcept;
 	/// @brief Operator to check if two Iterators are not the same
@@ -149,38 +291,51 @@ public:
 
 //impl
 
-template <class T>
-SkipList<T>::SkipList(const size_t maxLvl, const double _fraction)
-	: MAXLVL(maxLvl), fraction(_fraction), lvl(0)
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>::SkipList(const size_t maxLvl, const double _fraction)
+	: fraction(_fraction), MAXLVL(maxLvl), lvl(0)
 {
 	if (fraction < 0 || fraction >= 1) fraction = 0.5;
 	if (MAXLVL == 0) MAXLVL = 3;
 	else if (MAXLVL > MAX_POSSIBLE_LVL) MAXLVL = MAX_POSSIBLE_LVL;
-	first = new SLNode(T(), MAXLVL);
+	levelGen.setFraction(fraction);
+	first = SLNode::create(headerAlloc, T(), MAXLVL);
+}
+
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>::SkipList(const size_t maxLvl, const double _fraction, const uint64_t seed)
+	: SkipList(maxLvl, _fraction)
+{
+	levelGen.seed(seed);
 }
 //header SLNode is set as starting only and his value is not used
 
-template <class T>
-SkipList<T>::SkipList<T>(SkipList<T>&& other) noexcept
-	:MAXLVL(other.MAXLVL), fraction(other.fraction), lvl(other.lvl), first(other.first), size(other.size)
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>::SkipList<T, Alloc, LevelGen>(SkipList<T, Alloc, LevelGen>&& other) noexcept
+	:first(other.first), headerAlloc(std::move(other.headerAlloc)), alloc(std::move(other.alloc)), fraction(other.fraction),
+	MAXLVL(other.MAXLVL), lvl(other.lvl), size(other.size), levelGen(other.levelGen)
 {
 	other.first = nullptr;
 	other.lvl = 0;
 	other.size = 0;
+	for (int i = 0; i <= MAX_POSSIBLE_LVL; i++) {
+		freeSLNodes[i] = other.freeSLNodes[i];
+		other.freeSLNodes[i] = nullptr;
+	}
 }
 
-template <class T>
-SkipList<T>& SkipList<T>::operator=(const SkipList<T>& other)
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>& SkipList<T, Alloc, LevelGen>::operator=(const SkipList<T, Alloc, LevelGen>& other)
 {
 	if (&other != this) {
-		SkipList<T> newList(other);
+		SkipList<T, Alloc, LevelGen> newList(other);
 		*this = std::move(newList);
 	}
 	return *this;
 }
 
-template <class T>
-SkipList<T>& SkipList<T>::operator=(SkipList<T>&& other) noexcept
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>& SkipList<T, Alloc, LevelGen>::operator=(SkipList<T, Alloc, LevelGen>&& other) noexcept
 {
 	if (&other != this) {
 		clearAll();
@@ -189,54 +344,207 @@ SkipList<T>& SkipList<T>::operator=(SkipList<T>&& other) noexcept
 		std::swap(other.fraction, fraction);
 		std::swap(other.lvl, lvl);
 		std::swap(other.MAXLVL, MAXLVL);
+		for (int i = 0; i <= MAX_POSSIBLE_LVL; i++) {
+			std::swap(other.freeSLNodes[i], freeSLNodes[i]);
+		}
+		headerAlloc.swap(other.headerAlloc);
+		alloc.swap(other.alloc);
+		std::swap(other.levelGen, levelGen);
 	}
 	return *this;
 }
 
-template <class T>
-SkipList<T>::SkipList<T>(const SkipList<T>& other)
-	: MAXLVL(other.MAXLVL), fraction(other.fraction)
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>::SkipList<T, Alloc, LevelGen>(const SkipList<T, Alloc, LevelGen>& other)
+	: fraction(other.fraction), MAXLVL(other.MAXLVL), levelGen(other.levelGen)
+{
+	first = SLNode::create(headerAlloc, T(), MAXLVL);//may throw
+	try {
+		copyFrom(other);
+	}
+	catch (...) {
+		//copied SLNodes are already deleted
+		SLNode::destroy(headerAlloc, first);
+		first = nullptr;
+		throw;
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::cloneSegment(const SLNode* from, const SLNode* to, Alloc& a, Segment& seg)
 {
 	try {
-		first = new SLNode(other.first->value, other.first->lvl);
-		for (auto entry : other) {
-			insert(entry->value);
+		for (; from != to; from = from->lvlSLNodes[0]) {
+			SLNode* n = SLNode::create(a, from->value, from->lvl);//may throw
+			for (int i = 1; i <= from->lvl; i++) {
+				n->width(i) = from->span(i);
+			}
+			for (int i = 0; i <= from->lvl; i++) {
+				if (seg.tails[i]) seg.tails[i]->lvlSLNodes[i] = n;
+				else seg.heads[i] = n;
+				seg.tails[i] = n;
+			}
 		}
 	}
-	catch (...) {//fix
-		clearAll();
+	catch (...) {
+		destroySegment(a, seg);
 		throw;
 	}
+}
 
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::destroySegment(Alloc& a, Segment& seg) noexcept
+{
+	//the last SLNode on lvl 0 is not linked yet, so this stops at the end of the part
+	SLNode* cur = seg.heads[0];
+	while (cur) {
+		SLNode* next = cur->lvlSLNodes[0];
+		SLNode::destroy(a, cur);
+		cur = next;
+	}
+	seg = Segment();
+}
+
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::copyFrom(const SkipList<T, Alloc, LevelGen>& other)
+{
+	if (!other.first) return;
+	unsigned partCnt = 1;
+	if (other.size >= PARALLEL_COPY_MIN) {
+		partCnt = std::thread::hardware_concurrency();
+		if (partCnt > MAX_COPY_TASKS) partCnt = MAX_COPY_TASKS;
+		if (!partCnt) partCnt = 1;
+	}
+	std::vector<Segment> segs(partCnt);
+	if (partCnt == 1) {
+		cloneSegment(other.first->lvlSLNodes[0], nullptr, alloc, segs[0]);//may throw
+	}
+	else {
+		//parts start at equal distances found through the widths
+		std::vector<const SLNode*> starts(partCnt + 1, nullptr);
+		for (unsigned i = 0; i < partCnt; i++) {
+			starts[i] = other.nodeAt(other.size / partCnt * i);
+		}
+		std::vector<Alloc> allocs(partCnt);
+		std::vector<std::future<void>> tasks;
+		tasks.reserve(partCnt);
+		for (unsigned i = 0; i < partCnt; i++) {
+			auto job = [&starts, &allocs, &segs, i]() { cloneSegment(starts[i], starts[i + 1], allocs[i], segs[i]); };
+			try {
+				tasks.push_back(std::async(std::launch::async, job));
+			}
+			catch (...) {//no thread, copy it on get()
+				tasks.push_back(std::async(std::launch::deferred, job));
+			}
+		}
+		std::exception_ptr error;
+		for (unsigned i = 0; i < partCnt; i++) {
+			try {
+				tasks[i].get();
+			}
+			catch (...) {
+				if (!error) error = std::current_exception();
+			}
+			alloc.adopt(allocs[i]);
+		}
+		if (error) {
+			for (unsigned i = 0; i < partCnt; i++) {
+				destroySegment(alloc, segs[i]);
+			}
+			std::rethrow_exception(error);
+		}
+	}
+	//link the parts one after another on each lvl
+	SLNode* prev[MAX_POSSIBLE_LVL + 1];
+	for (int i = 0; i <= MAX_POSSIBLE_LVL; i++) {
+		prev[i] = first;
+	}
+	for (unsigned p = 0; p < partCnt; p++) {
+		for (size_t i = 0; i <= other.lvl; i++) {
+			if (!segs[p].heads[i]) continue;
+			prev[i]->lvlSLNodes[i] = segs[p].heads[i];
+			prev[i] = segs[p].tails[i];
+		}
+	}
+	for (size_t i = 1; i <= other.lvl; i++) {
+		first->width(i) = other.first->span(i);
+	}
+	lvl = other.lvl;
+	size = other.size;
 }
 
 
-template <class T>
-size_t SkipList<T>::randomLevel() const noexcept
+template <class T, class Alloc, class LevelGen>
+size_t SkipList<T, Alloc, LevelGen>::randomLevel() noexcept
 {
-	double r = (double)rand() / RAND_MAX;
-	size_t randLvl = 0;
-	while (r < fraction && randLvl < MAXLVL)
-	{
-		randLvl++;
-		r = (double)rand() / RAND_MAX;
+	return levelGen(MAXLVL);
+}
+
+template <class T, class Alloc, class LevelGen>
+typename SkipList<T, Alloc, LevelGen>::SLNode* SkipList<T, Alloc, LevelGen>::takeSLNode(const T& val, int _lvl)
+{
+	void* block = freeSLNodes[_lvl];
+	if (!block) return SLNode::create(alloc, val, _lvl);
+	freeSLNodes[_lvl] = *static_cast<void**>(block);
+	try {
+		return new (block) SLNode(val, _lvl);
+	}
+	catch (...) {
+		*static_cast<void**>(block) = freeSLNodes[_lvl];
+		freeSLNodes[_lvl] = block;
+		throw;
 	}
-	return randLvl;
 }
 
-template <class T>
-void SkipList<T>::clearAll() noexcept
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::keepSLNode(SLNode* node) noexcept
 {
-	if (!first || !first->lvlSLNodes[0]) return;
-	SLNode* prev = first->lvlSLNodes[0];
-	SLNode* cur = prev->lvlSLNodes[0];
+	int _lvl = node->lvl;
+	node->~SLNode();
+	void* block = node;
+	*static_cast<void**>(block) = freeSLNodes[_lvl];
+	freeSLNodes[_lvl] = block;
+}
 
-	while (cur) {
-		delete prev;
-		prev = cur;
-		cur = cur->lvlSLNodes[0];
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::releaseKept() noexcept
+{
+	for (int i = 0; i <= MAX_POSSIBLE_LVL; i++) {
+		void* block = freeSLNodes[i];
+		while (block) {
+			void* next = *static_cast<void**>(block);
+			alloc.deallocate(block, SLNode::bytesFor(i));
+			block = next;
+		}
+		freeSLNodes[i] = nullptr;
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::shrinkToFit() noexcept
+{
+	releaseKept();
+}
+
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::clearAll() noexcept
+{
+	if (!first) return;
+	if (!Alloc::BULK_RELEASE || !std::is_trivially_destructible<T>::value) {
+		SLNode* cur = first->lvlSLNodes[0];
+		while (cur) {
+			SLNode* next = cur->lvlSLNodes[0];
+			SLNode::destroy(alloc, cur);
+			cur = next;
+		}
+	}
+	if (!Alloc::BULK_RELEASE) {
+		releaseKept();
+	}
+	alloc.release();
+	for (int i = 0; i <= MAX_POSSIBLE_LVL; i++) {
+		freeSLNodes[i] = nullptr;
 	}
-	delete prev;
 	for (int i = 0; i <= MAXLVL; i++) {
 		first->lvlSLNodes[i] = nullptr;
 	}
@@ -244,14 +552,12 @@ void SkipList<T>::clearAll() noexcept
 	lvl = 0;
 }
 
-template <class T>
-typename SkipList<T>::SLNode* SkipList<T>::findSLNode(typename SkipList<T>::SLNode* start, const T& value) const noexcept
+template <class T, class Alloc, class LevelGen>
+typename SkipList<T, Alloc, LevelGen>::SLNode* SkipList<T, Alloc, LevelGen>::findSLNode(typename SkipList<T, Alloc, LevelGen>::SLNode* start, const T& value) const noexcept
 {
-	if (start && start == first && start->value == value) {
-		if (start->lvlSLNodes[0] && start->lvlSLNodes[0]->value == value) return start->lvlSLNodes[0];
-		else return nullptr;
-	}
-	if (!start || start->value == value) return start;
+	if (!start) return nullptr;
+	//the header's value is not used, so it is never compared
+	if (start != first && start->value == value) return start;
 
 	for (int i = lvl; i >= 0; i--) {
 		while (start->lvlSLNodes[i] && start->lvlSLNodes[i]->value < value)
@@ -265,19 +571,20 @@ typename SkipList<T>::SLNode* SkipList<T>::findSLNode(typename SkipList<T>::SLNo
 }
 
 
-template <class T>
-SkipList<T>::~SkipList<T>() noexcept
+template <class T, class Alloc, class LevelGen>
+SkipList<T, Alloc, LevelGen>::~SkipList<T, Alloc, LevelGen>() noexcept
 {
 	clearAll();
-	delete first;
+	if (first) SLNode::destroy(headerAlloc, first);
 	first = nullptr;
 }
 
-template <class T>
-bool SkipList<T>::insert(const T& val) noexcept
+template <class T, class Alloc, class LevelGen>
+bool SkipList<T, Alloc, LevelGen>::insert(const T& val) noexcept
 {
 
 	SLNode* cur = first;
+	size_t pos = 0;
 	// create update array and initialize it
 
 	for (int i = 0; i < MAXLVL + 1; i++) {
@@ -291,9 +598,11 @@ bool SkipList<T>::insert(const T& val) noexcept
 	{
 		while (cur->lvlSLNodes[i] && cur->lvlSLNodes[i]->value < val)
 		{
+			pos += cur->span(i);
 			cur = cur->lvlSLNodes[i];
 		}
 		update[i] = cur;
+		updatePos[i] = pos;
 	}
 
 	//lvl 0 and the next pointer should be the wanted place to insert
@@ -308,8 +617,11 @@ bool SkipList<T>::insert(const T& val) noexcept
 		//if lvl is higher than current ,init update value with pointer to header
 		if (rlevel > lvl)
 		{
-			for (int i = lvl + 1; i < rlevel + 1; i++)
+			for (int i = lvl + 1; i < rlevel + 1; i++) {
 				update[i] = first;
+				updatePos[i] = 0;
+				first->width(i) = size;
+			}
 
 			// change the current level
 			lvl = rlevel;
@@ -318,7 +630,7 @@ bool SkipList<T>::insert(const T& val) noexcept
 		// New SLNode with random level
 		SLNode* n;
 
-		n = new SLNode(val, rlevel);
+		n = takeSLNode(val, rlevel);
 		//ok to throw
 		
 		// insert SLNode by rearranging pointers
@@ -327,6 +639,18 @@ bool SkipList<T>::insert(const T& val) noexcept
 			n->lvlSLNodes[i] = update[i]->lvlSLNodes[i];
 			update[i]->lvlSLNodes[i] = n;
 		}
+		//split the widths of the links that now go through the new SLNode
+		//and count it in the higher links that go over it
+		for (int i = 1; i <= rlevel; i++)
+		{
+			size_t before = pos - updatePos[i];
+			n->width(i) = update[i]->width(i) - before;
+			update[i]->width(i) = before + 1;
+		}
+		for (size_t i = rlevel + 1; i <= lvl; i++)
+		{
+			++update[i]->width(i);
+		}
 
 		++size;
 
@@ -336,8 +660,8 @@ bool SkipList<T>::insert(const T& val) noexcept
 	return false;
 }
 
-template <class T>
-bool SkipList<T>::remove(const T& val) noexcept
+template <class T, class Alloc, class LevelGen>
+bool SkipList<T, Alloc, LevelGen>::remove(const T& val) noexcept
 {
 	SLNode* current = first;
 
@@ -363,51 +687,255 @@ bool SkipList<T>::remove(const T& val) noexcept
 	//if is searched SLNode
 	if (current && current->value == val)
 	{
-		//starts from lowest and rearrange to remove the target
-		for (int i = 0; i <= lvl; i++)
-		{
-			//if is not wanted SLNode on this lvl, more on next
-			if (update[i]->lvlSLNodes[i] != current)
-				break;
+		unlinkSLNode(current);
+		return true;
+	}
+
+	return false; //not found
+}
+
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::unlinkSLNode(SLNode* current) noexcept
+{
+	//starts from lowest and rearrange to remove the target
+	for (size_t i = 0; i <= lvl; i++)
+	{
+		if (update[i]->lvlSLNodes[i] == current) {
 			//update
 			update[i]->lvlSLNodes[i] = current->lvlSLNodes[i];
+			if (i) update[i]->width(i) += current->width(i) - 1;
 		}
+		else {
+			//the link goes over the target, so it skips one SLNode less
+			--update[i]->width(i);
+		}
+	}
+	keepSLNode(current);
+
+	// Remove empty lvls
+	while (lvl > 0 && !first->lvlSLNodes[lvl])
+	{
+		--lvl;
+	}
 
-		// Remove empty lvls
-		while (lvl > 0 && !first->lvlSLNodes[lvl])
+	--size;
+}
+
+template <class T, class Alloc, class LevelGen>
+template <class It>
+bool SkipList<T, Alloc, LevelGen>::buildFromSorted(It from, It to)
+{
+	//checking pass, so nothing is changed for wrong input
+	for (It prev = from, it = from; it != to; prev = it++) {
+		if (prev != it && !(*prev < *it)) return false;
+	}
+	SkipList<T, Alloc, LevelGen> built(MAXLVL, fraction);
+	built.levelGen = levelGen;
+	//last SLNode on each lvl and its position
+	SLNode* tail[MAX_POSSIBLE_LVL + 1];
+	size_t tailPos[MAX_POSSIBLE_LVL + 1];
+	for (int i = 0; i <= (int)built.MAXLVL; i++) {
+		tail[i] = built.first;
+		tailPos[i] = 0;
+	}
+	size_t pos = 0;
+	for (It it = from; it != to; ++it) {
+		int rlevel = built.randomLevel();
+		SLNode* n = built.takeSLNode(*it, rlevel);//ok to throw, linked SLNodes are deleted with built
+		++pos;
+		for (int i = 0; i <= rlevel; i++) {
+			tail[i]->lvlSLNodes[i] = n;
+			if (i) tail[i]->width(i) = pos - tailPos[i];
+			tail[i] = n;
+			tailPos[i] = pos;
+		}
+		if (rlevel > (int)built.lvl) built.lvl = rlevel;
+		built.size = pos;
+	}
+	//the last links on each lvl skip the SLNodes after them
+	for (int i = 1; i <= (int)built.lvl; i++) {
+		tail[i]->width(i) = pos - tailPos[i];
+	}
+	*this = std::move(built);
+	return true;
+}
+
+template <class T, class Alloc, class LevelGen>
+typename SkipList<T, Alloc, LevelGen>::SLNode* SkipList<T, Alloc, LevelGen>::firstNotLess(const T& value) const noexcept
+{
+	SLNode* cur = first;
+	for (int i = lvl; i >= 0; i--)
+	{
+		while (cur->lvlSLNodes[i] && cur->lvlSLNodes[i]->value < value)
 		{
-			--lvl;
+			cur = cur->lvlSLNodes[i];
 		}
-		
-		--size;
-		return true;
 	}
+	return cur->lvlSLNodes[0];
+}
 
-	return false; //not found
+template <class T, class Alloc, class LevelGen>
+const T* SkipList<T, Alloc, LevelGen>::lowerBound(const T& val) const noexcept
+{
+	SLNode* cur = firstNotLess(val);
+	return cur ? &cur->value : nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+const T* SkipList<T, Alloc, LevelGen>::upperBound(const T& val) const noexcept
+{
+	SLNode* cur = firstNotLess(val);
+	//no repetitions, so only the first one can be equal
+	if (cur && !(val < cur->value)) cur = cur->lvlSLNodes[0];
+	return cur ? &cur->value : nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+template <class F>
+void SkipList<T, Alloc, LevelGen>::forEachInRange(const T& lo, const T& hi, F f) const
+{
+	for (SLNode* cur = firstNotLess(lo); cur && cur->value < hi; cur = cur->lvlSLNodes[0]) {
+		f(cur->value);
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+typename SkipList<T, Alloc, LevelGen>::SLNode* SkipList<T, Alloc, LevelGen>::nodeAt(size_t k) const noexcept
+{
+	if (k >= size) return nullptr;
+	//positions start from 1 after the header
+	size_t target = k + 1, pos = 0;
+	SLNode* cur = first;
+	for (int i = lvl; i >= 0; i--)
+	{
+		while (cur->lvlSLNodes[i] && pos + cur->span(i) <= target)
+		{
+			pos += cur->span(i);
+			cur = cur->lvlSLNodes[i];
+		}
+		if (pos == target) return cur;
+	}
+	return nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+const T* SkipList<T, Alloc, LevelGen>::at(size_t k) const noexcept
+{
+	SLNode* cur = nodeAt(k);
+	return cur ? &cur->value : nullptr;
 }
 
-template <class T>
-bool SkipList<T>::exists(const T& val) const noexcept
+template <class T, class Alloc, class LevelGen>
+size_t SkipList<T, Alloc, LevelGen>::indexOf(const T& val) const noexcept
+{
+	size_t pos = 0;
+	SLNode* cur = first;
+	for (int i = lvl; i >= 0; i--)
+	{
+		while (cur->lvlSLNodes[i] && cur->lvlSLNodes[i]->value < val)
+		{
+			pos += cur->span(i);
+			cur = cur->lvlSLNodes[i];
+		}
+	}
+	cur = cur->lvlSLNodes[0];
+	return cur && cur->value == val ? pos : size;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool SkipList<T, Alloc, LevelGen>::eraseAt(size_t k) noexcept
+{
+	if (k >= size) return false;
+	size_t target = k + 1, pos = 0;
+	SLNode* cur = first;
+	//update keeps the last SLNodes before the target on each lvl
+	for (int i = lvl; i >= 0; i--)
+	{
+		while (cur->lvlSLNodes[i] && pos + cur->span(i) < target)
+		{
+			pos += cur->span(i);
+			cur = cur->lvlSLNodes[i];
+		}
+		update[i] = cur;
+	}
+	unlinkSLNode(cur->lvlSLNodes[0]);
+	return true;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool SkipList<T, Alloc, LevelGen>::exists(const T& val) const noexcept
 {
 	//return findSLNode(header[lvl], val) != nullptr;
 	return findSLNode(first, val) != nullptr;
 }
 
-template <class T>
-size_t SkipList<T>::getSize() const noexcept
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::existsMany(const T* vals, size_t n, bool* out) const noexcept
+{
+	/// @brief State of one search: the SLNode reached, the next one on its lvl i (being prefetched)
+	/// and the value index
+	struct Probe {
+		const SLNode* cur;
+		const SLNode* next;
+		int i;
+		size_t idx;
+	};
+	Probe probes[LOOKUP_GROUP];
+	size_t active = 0, nextVal = 0;
+	if (!first) {
+		for (size_t k = 0; k < n; k++) out[k] = false;
+		return;
+	}
+	while (active < LOOKUP_GROUP && nextVal < n) {
+		probes[active++] = { first, first->lvlSLNodes[lvl], (int)lvl, nextVal++ };
+		prefetchRead(first->lvlSLNodes[lvl]);
+	}
+	while (active) {
+		for (size_t p = 0; p < active;) {
+			Probe& probe = probes[p];
+			const T& val = vals[probe.idx];
+			if (probe.next && probe.next->value < val) {
+				probe.cur = probe.next;
+			}
+			else if (probe.i == 0) {
+				//lvl 0 and maybe the wanted SLNode, the place goes to the next value
+				out[probe.idx] = probe.next && probe.next->value == val;
+				if (nextVal < n) {
+					probe = { first, first->lvlSLNodes[lvl], (int)lvl, nextVal++ };
+					p++;
+				}
+				else probe = probes[--active];
+				continue;
+			}
+			else --probe.i;
+			probe.next = probe.cur->lvlSLNodes[probe.i];
+			prefetchRead(probe.next);
+			p++;
+		}
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+size_t SkipList<T, Alloc, LevelGen>::getSize() const noexcept
 {
 	return size;
 }
 
-template <class T>
-void SkipList<T>::clearData() noexcept
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::clearData() noexcept
 {
 	clearAll();
 }
 
+template <class T, class Alloc, class LevelGen>
+void SkipList<T, Alloc, LevelGen>::seed(const uint64_t seed) noexcept
+{
+	levelGen.seed(seed);
+}
+
 
-template<class T>
-inline void SkipList<T>::printLvls() const noexcept
+template<class T, class Alloc, class LevelGen>
+inline void SkipList<T, Alloc, LevelGen>::printLvls() const noexcept
 {
 	SLNode* cur;
 	for (int i = 0; i < lvl; i++) {
@@ -420,55 +948,49 @@ inline void SkipList<T>::printLvls() const noexcept
 	}
 }
 
-template <class T>
-SListIterator<T> SkipList<T>::begin() const noexcept
+template <class T, class Alloc, class LevelGen>
+SListIterator<T, Alloc, LevelGen> SkipList<T, Alloc, LevelGen>::begin() const noexcept
 {
-	if (!first) return SListIterator<T>(nullptr);
-	return SListIterator<T>(first->lvlSLNodes[0]);
+	if (!first) return SListIterator<T, Alloc, LevelGen>(nullptr);
+	return SListIterator<T, Alloc, LevelGen>(first->lvlSLNodes[0]);
 }
 
-template <class T>
-SListIterator<T> SkipList<T>::end() const noexcept
+template <class T, class Alloc, class LevelGen>
+SListIterator<T, Alloc, LevelGen> SkipList<T, Alloc, LevelGen>::end() const noexcept
 {
-	return SListIterator<T>(nullptr);
+	return SListIterator<T, Alloc, LevelGen>(nullptr);
 }
 
-template <class T>
-size_t SkipList<T>::getBytesUsed() const noexcept
+template <class T, class Alloc, class LevelGen>
+size_t SkipList<T, Alloc, LevelGen>::getBytesUsed() const noexcept
 {
-	size_t nodesBytes = 0;
-	SLNode* cur = first;
-	while (cur) {
-		nodesBytes += cur->getBytesUsed();
-		cur = cur->lvlSLNodes[0];
-	}
-	return sizeof(SkipList<T>) + nodesBytes;
+	return sizeof(SkipList<T, Alloc, LevelGen>) + headerAlloc.getBytesUsed() + alloc.getBytesUsed();
 }
 
 //iter
-template <class T>
-SListIterator<T> SListIterator<T>::operator++()
+template <class T, class Alloc, class LevelGen>
+SListIterator<T, Alloc, LevelGen> SListIterator<T, Alloc, LevelGen>::operator++()
 {
 	if (current) current = current->lvlSLNodes[0];
 	return *this;
 }
 
-template <class T>
-SListIterator<T>::SListIterator(typename SkipList<T>::SLNode* headerSLNode) noexcept
+template <class T, class Alloc, class LevelGen>
+SListIterator<T, Alloc, LevelGen>::SListIterator(typename SkipList<T, Alloc, LevelGen>::SLNode* headerSLNode) noexcept
 	:current(headerSLNode) {}
 
-template <class T>
-const typename SkipList<T>::SLNode* SListIterator<T>::operator*() const
+template <class T, class Alloc, class LevelGen>
+const typename SkipList<T, Alloc, LevelGen>::SLNode* SListIterator<T, Alloc, LevelGen>::operator*() const
 {
 	return current;
 }
 
-template <class T>
-bool SListIterator<T>::operator==(const SListIterator<T>& other) const noexcept {
+template <class T, class Alloc, class LevelGen>
+bool SListIterator<T, Alloc, LevelGen>::operator==(const SListIterator<T, Alloc, LevelGen>& other) const noexcept {
 	return operator*() == *other;
 }
 
-template <class T>
-bool SListIterator<T>::operator!=(const SListIterator<T>& other) const noexcept {
+template <class T, class Alloc, class LevelGen>
+bool SListIterator<T, Alloc, LevelGen>::operator!=(const SListIterator<T, Alloc, LevelGen>& other) const noexcept {
 	return operator*() != *other;
 }
\ No newline at end of file
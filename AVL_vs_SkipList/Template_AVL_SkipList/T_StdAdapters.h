@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+/// @brief Allocator that adds the bytes of every allocation to a counter, so the memory of standard containers
+/// can be shown next to getBytesUsed() of the other structures. Copies and rebinds share the counter
+template <class T>
+class CountingAllocator {
+public:
+	using value_type = T;
+	//data
+	/// @brief Bytes allocated and not freed yet by all allocators with this counter
+	size_t* bytes;
+
+	explicit CountingAllocator(size_t* counter) noexcept : bytes(counter) {}
+	template <class U>
+	CountingAllocator(const CountingAllocator<U>& other) noexcept : bytes(other.bytes) {}
+	T* allocate(size_t n)
+	{
+		T* p = std::allocator<T>().allocate(n);//may throw
+		*bytes += n * sizeof(T);
+		return p;
+	}
+	void deallocate(T* p, size_t n) noexcept
+	{
+		*bytes -= n * sizeof(T);
+		std::allocator<T>().deallocate(p, n);
+	}
+	template <class U>
+	bool operator==(const CountingAllocator<U>& other) const noexcept { return bytes == other.bytes; }
+	template <class U>
+	bool operator!=(const CountingAllocator<U>& other) const noexcept { return bytes != other.bytes; }
+};
+
+/// @brief std::set (red-black tree) with the surface of the benchmarked structures
+template <class T>
+class StdSetAdapter {
+private:
+	//data
+	size_t bytes = 0;
+	std::set<T, std::less<T>, CountingAllocator<T>> set{ std::less<T>(), CountingAllocator<T>(&bytes) };
+public:
+	StdSetAdapter() = default;
+	/// @brief The allocator points to the adapter's own counter, so it is not copied or moved
+	StdSetAdapter(const StdSetAdapter&) = delete;
+	StdSetAdapter& operator=(const StdSetAdapter&) = delete;
+	bool insert(const T& key) { return set.insert(key).second; }
+	bool remove(const T& key) { return set.erase(key) != 0; }
+	bool exists(const T& key) const { return set.find(key) != set.end(); }
+	size_t getSize() const noexcept { return set.size(); }
+	void clearData() noexcept { set.clear(); }
+	size_t getBytesUsed() const noexcept { return sizeof(*this) + bytes; }
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const
+	{
+		for (auto it = set.lower_bound(lo); it != set.end() && *it < hi; ++it) {
+			f(*it);
+		}
+	}
+	/// @brief Replaces the values with sorted ones in O(n) (insert with a hint at the end). False for unsorted input
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		for (It prev = first, it = first; it != last; prev = it++) {
+			if (prev != it && !(*prev < *it)) return false;
+		}
+		set.clear();
+		for (; first != last; ++first) {
+			set.emplace_hint(set.end(), *first);
+		}
+		return true;
+	}
+};
+
+/// @brief std::unordered_set (hash table) with the surface of the benchmarked structures.
+/// It has no order: forEachInRange() checks every value and calls f in no particular order
+template <class T>
+class UnorderedSetAdapter {
+private:
+	//data
+	size_t bytes = 0;
+	std::unordered_set<T, std::hash<T>, std::equal_to<T>, CountingAllocator<T>> set{ 0, std::hash<T>(), std::equal_to<T>(), CountingAllocator<T>(&bytes) };
+public:
+	UnorderedSetAdapter() = default;
+	/// @brief The allocator points to the adapter's own counter, so it is not copied or moved
+	UnorderedSetAdapter(const UnorderedSetAdapter&) = delete;
+	UnorderedSetAdapter& operator=(const UnorderedSetAdapter&) = delete;
+	bool insert(const T& key) { return set.insert(key).second; }
+	bool remove(const T& key) { return set.erase(key) != 0; }
+	bool exists(const T& key) const { return set.find(key) != set.end(); }
+	size_t getSize() const noexcept { return set.size(); }
+	void clearData() noexcept { set.clear(); }
+	size_t getBytesUsed() const noexcept { return sizeof(*this) + bytes; }
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const
+	{
+		for (const T& value : set) {
+			if (!(value < lo) && value < hi) f(value);
+		}
+	}
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		for (It prev = first, it = first; it != last; prev = it++) {
+			if (prev != it && !(*prev < *it)) return false;
+		}
+		set.clear();
+		set.reserve((size_t)std::distance(first, last));
+		set.insert(first, last);
+		return true;
+	}
+};
+
+/// @brief Sorted std::vector with the surface of the benchmarked structures: binary search for lookups,
+/// O(n) moves for each insert and remove, no memory per value besides the value itself
+template <class T>
+class SortedVectorAdapter {
+private:
+	//data
+	size_t bytes = 0;
+	std::vector<T, CountingAllocator<T>> values{ CountingAllocator<T>(&bytes) };
+public:
+	SortedVectorAdapter() = default;
+	/// @brief The allocator points to the adapter's own counter, so it is not copied or moved
+	SortedVectorAdapter(const SortedVectorAdapter&) = delete;
+	SortedVectorAdapter& operator=(const SortedVectorAdapter&) = delete;
+	bool insert(const T& key)
+	{
+		auto it = std::lower_bound(values.begin(), values.end(), key);
+		if (it != values.end() && !(key < *it)) return false;
+		values.insert(it, key);
+		return true;
+	}
+	bool remove(const T& key)
+	{
+		auto it = std::lower_bound(values.begin(), values.end(), key);
+		if (it == values.end() || key < *it) return false;
+		values.erase(it);
+		return true;
+	}
+	bool exists(const T& key) const { return std::binary_search(values.begin(), values.end(), key); }
+	size_t getSize() const noexcept { return values.size(); }
+	/// @brief Keeps the capacity, as the other structures keep their allocated chunks
+	void clearData() noexcept { values.clear(); }
+	size_t getBytesUsed() const noexcept { return sizeof(*this) + bytes; }
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const
+	{
+		for (auto it = std::lower_bound(values.begin(), values.end(), lo); it != values.end() && *it < hi; ++it) {
+			f(*it);
+		}
+	}
+	template <class It>
+	bool buildFromSorted(It first, It last)
+	{
+		for (It prev = first, it = first; it != last; prev = it++) {
+			if (prev != it && !(*prev < *it)) return false;
+		}
+		values.assign(first, last);
+		return true;
+	}
+};
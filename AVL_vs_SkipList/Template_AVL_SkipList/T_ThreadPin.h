@@ -0,0 +1,36 @@
+#pragma once
+#include <thread>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// @brief Returns the number of logical processors. At least 1
+inline unsigned processorCount() noexcept
+{
+	unsigned cnt = std::thread::hardware_concurrency();
+	return cnt ? cnt : 1;
+}
+
+/// @brief Binds the calling thread to one logical processor (taken modulo their number), so the
+/// scheduler does not move it between cores during a measurement. Returns false where that is not supported
+inline bool pinThisThread(unsigned cpu) noexcept
+{
+	cpu %= processorCount();
+#if defined(_WIN32)
+	if (cpu >= sizeof(DWORD_PTR) * 8) return false; //only the first processor group
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,706 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "T_NodeAllocator.h"
+#include "T_LevelGenerator.h"
+#include "T_BlockSearch.h"
+
+template <class T, class Alloc = SlabAllocator<>, class LevelGen = XorShiftLevelGenerator>
+class UnrolledSListIterator;
+
+/// @brief Unrolled Skip List with no repetitions rule. Every node is a block of up to BLOCK_CAP sorted values
+/// and the lvls link blocks instead of single values, so the pointers of a node are shared by all of its values
+/// and lvl 0 is walked value after value inside a block. The blocks follow each other in ascending order and
+/// the lvls compare with the smallest value of a block.
+/// A full block is split in two on insert, a block with less than BLOCK_MIN values takes values from
+/// the next block or is merged with it on remove.
+/// T has to be default constructible and assignable, as blocks keep arrays of values
+/// @tparam Alloc Node allocator policy (see T_NodeAllocator.h)
+/// @tparam LevelGen Level generator policy (see T_LevelGenerator.h)
+template <class T, class Alloc = SlabAllocator<>, class LevelGen = XorShiftLevelGenerator>
+class UnrolledSkipList
+{
+private:
+	/// @brief Number of values that a block holds: 128 bytes of values (2 cache lines), at least 8
+	static const size_t BLOCK_CAP = 128 / sizeof(T) > 8 ? 128 / sizeof(T) : 8;
+	/// @brief Least values in a block, except for the last one
+	static const size_t BLOCK_MIN = BLOCK_CAP / 4;
+	/// @brief Values put in a block by buildFromSorted(), so the next inserts do not split at once.
+	/// Two blocks are merged on remove only when they fit in that many values
+	static const size_t BLOCK_FILL = BLOCK_CAP - BLOCK_CAP / 4;
+	/// @brief Maximum lvl. The lvls index blocks, so this is enough for far more than 2^35 values
+	static const int MAX_POSSIBLE_LVL = 35;
+
+	struct Block
+	{
+		/// @brief Number of values in the block
+		unsigned short count;
+		/// @brief The lvl of the block - number of pointers that it has
+		const unsigned short lvl;
+		/// @brief Array to hold pointers to the next blocks of different levels.
+		/// Allocated in the same block right after the node so it holds lvl + 1 pointers.
+		/// The values follow the pointers, so the pointers and the smallest value are in the same cache line
+		Block* next[1];
+
+		/// @brief Constructor to set the lvl. Use createBlock() so the pointers and the values get allocated
+		Block(int _lvl)
+			:count(0), lvl((unsigned short)_lvl)
+		{
+			for (int i = 0; i < _lvl + 1; i++) {
+				next[i] = nullptr;
+			}
+		}
+
+		/// @brief Returns the size of the block that holds a node with given lvl and place for cap values
+		static size_t bytesFor(int _lvl, size_t cap) noexcept
+		{
+			return sizeof(Block) + sizeof(Block*) * _lvl + sizeof(T) * cap;
+		}
+
+		/// @brief Returns the array of BLOCK_CAP values after the pointers
+		T* values() noexcept
+		{
+			return reinterpret_cast<T*>(next + lvl + 1);
+		}
+		const T* values() const noexcept
+		{
+			return reinterpret_cast<const T*>(next + lvl + 1);
+		}
+	};
+	static_assert(alignof(T) <= alignof(Block*), "Values are kept after the pointers, so they can not need a bigger alignment");
+	static_assert(alignof(Block) <= Alloc::ALIGNMENT, "Allocator alignment is too small for the blocks");
+
+	//data
+	/// @brief Pointer to the header block. It has MAXLVL lvl and no values
+	Block* first = nullptr;
+	/// @brief Allocator that gives the memory for the header block.
+	/// The header is kept out of the blocks' allocator so clearing can release all of its chunks
+	HeapAllocator headerAlloc;
+	/// @brief Allocator that gives the memory for the blocks
+	Alloc alloc;
+
+	/// @brief Fraction of the blocks with level X pointers that also have next level pointers.
+	double fraction;
+
+	/// @brief Maximum level that the list can have
+	size_t MAXLVL;
+
+	/// @brief Current highest lvl on a block in the list
+	size_t lvl = 0;
+
+	/// @brief Number of values in the list
+	size_t size = 0;
+
+	/// @brief Number of blocks (without the header) in the list
+	size_t blockCnt = 0;
+
+	/// @brief Generator of the random lvls for the new blocks
+	LevelGen levelGen;
+
+	//private methods
+	/// @brief Returns a random integer value that is not more than the MAXLVL
+	size_t randomLevel() noexcept;
+	/// @brief Returns the number of values less than val. Integral values are compared many at once (see T_BlockSearch.h)
+	static size_t lowerIndex(const T* values, size_t cnt, const T& val) noexcept;
+	/// @brief Method to allocate the header block with MAXLVL lvl
+	void createHeader();
+	/// @brief Method to allocate a block with given lvl and construct it and its BLOCK_CAP values there
+	Block* createBlock(int _lvl);
+	/// @brief Method to destruct a block and its values and give its memory back to the allocator
+	void destroyBlock(Block* block) noexcept;
+	/// @brief Method to delete all blocks (without the header) and set size to 0
+	void clearAll() noexcept;
+	/// @brief Method to copy the blocks of other (the list must be empty). Each block gets the same lvl and values
+	void copyFrom(const UnrolledSkipList& other);
+	/// @brief Returns the last block whose smallest value is not greater than val. The header if there is none
+	Block* findBlock(const T& val) const noexcept;
+	/// @brief Method to fill prev with the last block on each lvl (up to MAXLVL) whose smallest value is less than val.
+	/// For the smallest value of a block these are the blocks before it on each lvl
+	void findPrev(const T& val, Block** prev) const noexcept;
+	/// @brief Method to link a block after the prev blocks on its lvls
+	void link(Block* block, Block** prev) noexcept;
+	/// @brief Method to unlink a block that is after the prev blocks on its lvls and to remove empty lvls
+	void unlink(Block* block, Block** prev) noexcept;
+public:
+	friend class UnrolledSListIterator<T, Alloc, LevelGen>;
+	//constructors and operators
+	/// @brief Standart constructor creating empty list with set maximum lvl and a fraction. The lvls index blocks,
+	/// so maxLvl for the expected number of blocks is enough
+	/// @param maxLvl max lvl size (should be less than 35)
+	/// @param fraction Fraction of the blocks with level X pointers that also have next level pointers.
+	UnrolledSkipList(const size_t maxLvl, const double fraction);
+	/// @brief Constructor like the one above that also seeds the level generator, so the lvls can be repeated
+	UnrolledSkipList(const size_t maxLvl, const double fraction, const uint64_t seed);
+	/// @brief Copy constructor. Copies the blocks as they are in O(n)
+	/// @param other List to be copied
+	UnrolledSkipList(const UnrolledSkipList& other);
+	/// @brief Move constructor.
+	/// @param other List to be moved. Moved object will be empty
+	UnrolledSkipList(UnrolledSkipList&& other) noexcept;
+	/// @brief Copy operator. Nothing is changed if the copy fails
+	/// @param other List to be copied
+	UnrolledSkipList& operator=(const UnrolledSkipList& other);
+	/// @brief Move operator.
+	/// @param other List to be moved. Moved object will be empty
+	UnrolledSkipList& operator=(UnrolledSkipList&& other) noexcept;
+	/// @brief Destructor
+	~UnrolledSkipList() noexcept;
+	//public methods
+	/// @brief Returns the number of values in the list
+	size_t getSize() const noexcept;
+	/// @brief Returns the number of blocks in the list
+	size_t getBlockCount() const noexcept;
+	/// @brief Inserts a value. Returns if operation was successful.
+	/// A full block is split in two and the new one gets a random lvl.
+	/// May throw std::bad_alloc on a split, then the list is not changed
+	bool insert(const T& val);
+	/// @brief Removes a value. Returns if operation was successful.
+	/// A block left with less than BLOCK_MIN values takes values from the next block or is merged with it
+	bool remove(const T& val) noexcept;
+	/// @brief Returns if such value exists
+	bool exists(const T& val) const noexcept;
+	/// @brief Replaces the data with the values in [from, to) in O(n) after a checking pass,
+	/// so It has to be a forward iterator. The values have to be in strictly ascending order,
+	/// the blocks get BLOCK_FILL values each
+	/// @return False (and nothing is changed) if the values are not strictly ascending
+	template <class It>
+	bool buildFromSorted(It from, It to);
+	/// @brief Returns pointer to the smallest value not less than val. nullptr if there is none
+	const T* lowerBound(const T& val) const noexcept;
+	/// @brief Returns pointer to the smallest value greater than val. nullptr if there is none
+	const T* upperBound(const T& val) const noexcept;
+	/// @brief Calls f(value) for every value in [lo, hi) in ascending order.
+	/// Goes down to lo once and then walks the values of the blocks on lvl 0
+	template <class F>
+	void forEachInRange(const T& lo, const T& hi, F f) const;
+	/// @brief Deletes all blocks and sets size to 0. With a bulk releasing allocator
+	/// the memory is freed by chunks instead of block by block
+	void clearData() noexcept;
+	//iteration
+	/// @brief Returns iterator to the smallest value
+	UnrolledSListIterator<T, Alloc, LevelGen> begin() const noexcept;
+	/// @brief Returns iterator to the end (nullptr)
+	UnrolledSListIterator<T, Alloc, LevelGen> end() const noexcept;
+	/// @brief Returns the memory used by the structure in bytes
+	size_t getBytesUsed() const noexcept;
+};
+
+/// @brief Unrolled Skip List iterator that walks the blocks on lvl 0 (ascending order).
+/// Like the B+ tree iterator it gives pointers to the values, as the blocks hold many of them
+template <class T, class Alloc, class LevelGen>
+class UnrolledSListIterator {
+private:
+	//data
+	/// @brief Current block. nullptr at the end
+	const typename UnrolledSkipList<T, Alloc, LevelGen>::Block* block;
+	/// @brief Index of the current value in the block
+	size_t pos;
+	//methods
+	/// @brief Constructor that starts from the first value of a block
+	UnrolledSListIterator(const typename UnrolledSkipList<T, Alloc, LevelGen>::Block* start) noexcept;
+public:
+	friend class UnrolledSkipList<T, Alloc, LevelGen>;
+	//methods
+	/// @brief Operator to move to the next value in the order.
+	UnrolledSListIterator& operator++() noexcept;
+	/// @brief Operator to get pointer to the current value. nullptr at the end
+	const T* operator*() const noexcept;
+	/// @brief Operator to check if two Iterators are the same
+	bool operator==(const UnrolledSListIterator& other) const noexcept;
+	/// @brief Operator to check if two Iterators are not the same
+	bool operator!=(const UnrolledSListIterator& other) const noexcept;
+};
+
+//impl
+
+template <class T, class Alloc, class LevelGen>
+size_t UnrolledSkipList<T, Alloc, LevelGen>::randomLevel() noexcept
+{
+	return levelGen(MAXLVL);
+}
+
+template <class T, class Alloc, class LevelGen>
+size_t UnrolledSkipList<T, Alloc, LevelGen>::lowerIndex(const T* values, size_t cnt, const T& val) noexcept
+{
+	return BlockSearch<T>::lowerIndex(values, cnt, val);
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::createHeader()
+{
+	void* memory = headerAlloc.allocate(Block::bytesFor((int)MAXLVL, 0));//may throw
+	first = new (memory) Block((int)MAXLVL);
+}
+
+template <class T, class Alloc, class LevelGen>
+typename UnrolledSkipList<T, Alloc, LevelGen>::Block* UnrolledSkipList<T, Alloc, LevelGen>::createBlock(int _lvl)
+{
+	void* memory = alloc.allocate(Block::bytesFor(_lvl, BLOCK_CAP));//may throw
+	Block* block = new (memory) Block(_lvl);
+	T* values = block->values();
+	size_t done = 0;
+	try {
+		for (; done < BLOCK_CAP; done++) {
+			new (values + done) T;
+		}
+	}
+	catch (...) {
+		for (size_t i = 0; i < done; i++) {
+			values[i].~T();
+		}
+		block->~Block();
+		alloc.deallocate(memory, Block::bytesFor(_lvl, BLOCK_CAP));
+		throw;
+	}
+	return block;
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::destroyBlock(Block* block) noexcept
+{
+	int _lvl = block->lvl;
+	T* values = block->values();
+	for (size_t i = 0; i < BLOCK_CAP; i++) {
+		values[i].~T();
+	}
+	block->~Block();
+	alloc.deallocate(block, Block::bytesFor(_lvl, BLOCK_CAP));
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::clearAll() noexcept
+{
+	if (!first) return;
+	if (!Alloc::BULK_RELEASE || !std::is_trivially_destructible<T>::value) {
+		Block* cur = first->next[0];
+		while (cur) {
+			Block* next = cur->next[0];
+			destroyBlock(cur);
+			cur = next;
+		}
+	}
+	alloc.release();
+	for (size_t i = 0; i <= MAXLVL; i++) {
+		first->next[i] = nullptr;
+	}
+	size = 0;
+	blockCnt = 0;
+	lvl = 0;
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::copyFrom(const UnrolledSkipList& other)
+{
+	//last block on each lvl. Every copied block is linked at once, so clearAll() deletes them if a copy fails
+	Block* tail[MAX_POSSIBLE_LVL + 1];
+	for (size_t i = 0; i <= MAXLVL; i++) {
+		tail[i] = first;
+	}
+	for (const Block* from = other.first->next[0]; from; from = from->next[0]) {
+		Block* b = createBlock(from->lvl);//may throw
+		try {
+			std::copy(from->values(), from->values() + from->count, b->values());
+		}
+		catch (...) {
+			destroyBlock(b);
+			throw;
+		}
+		b->count = from->count;
+		for (int i = 0; i <= from->lvl; i++) {
+			tail[i]->next[i] = b;
+			tail[i] = b;
+		}
+		if (from->lvl > lvl) lvl = from->lvl;
+		size += b->count;
+		++blockCnt;
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+typename UnrolledSkipList<T, Alloc, LevelGen>::Block* UnrolledSkipList<T, Alloc, LevelGen>::findBlock(const T& val) const noexcept
+{
+	Block* cur = first;
+	for (int i = (int)lvl; i >= 0; i--) {
+		while (cur->next[i] && !(val < cur->next[i]->values()[0])) {
+			cur = cur->next[i];
+		}
+	}
+	return cur;
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::findPrev(const T& val, Block** prev) const noexcept
+{
+	for (size_t i = MAXLVL; i > lvl; i--) {
+		prev[i] = first;
+	}
+	Block* cur = first;
+	for (int i = (int)lvl; i >= 0; i--) {
+		while (cur->next[i] && cur->next[i]->values()[0] < val) {
+			cur = cur->next[i];
+		}
+		prev[i] = cur;
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::link(Block* block, Block** prev) noexcept
+{
+	for (int i = 0; i <= block->lvl; i++) {
+		block->next[i] = prev[i]->next[i];
+		prev[i]->next[i] = block;
+	}
+	if (block->lvl > lvl) lvl = block->lvl;
+	++blockCnt;
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::unlink(Block* block, Block** prev) noexcept
+{
+	for (int i = 0; i <= block->lvl; i++) {
+		prev[i]->next[i] = block->next[i];
+	}
+	// Remove empty lvls
+	while (lvl > 0 && !first->next[lvl]) {
+		--lvl;
+	}
+	--blockCnt;
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>::UnrolledSkipList(const size_t maxLvl, const double _fraction)
+	: fraction(_fraction), MAXLVL(maxLvl)
+{
+	if (fraction < 0 || fraction >= 1) fraction = 0.5;
+	if (MAXLVL == 0) MAXLVL = 3;
+	else if (MAXLVL > MAX_POSSIBLE_LVL) MAXLVL = MAX_POSSIBLE_LVL;
+	levelGen.setFraction(fraction);
+	createHeader();
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>::UnrolledSkipList(const size_t maxLvl, const double _fraction, const uint64_t seed)
+	: UnrolledSkipList(maxLvl, _fraction)
+{
+	levelGen.seed(seed);
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>::UnrolledSkipList(const UnrolledSkipList& other)
+	: fraction(other.fraction), MAXLVL(other.MAXLVL), levelGen(other.levelGen)
+{
+	createHeader();//may throw
+	try {
+		copyFrom(other);
+	}
+	catch (...) {
+		clearAll();
+		first->~Block();
+		headerAlloc.deallocate(first, Block::bytesFor((int)MAXLVL, 0));
+		first = nullptr;
+		throw;
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>::UnrolledSkipList(UnrolledSkipList&& other) noexcept
+	: first(other.first), headerAlloc(std::move(other.headerAlloc)), alloc(std::move(other.alloc)), fraction(other.fraction),
+	MAXLVL(other.MAXLVL), lvl(other.lvl), size(other.size), blockCnt(other.blockCnt), levelGen(other.levelGen)
+{
+	other.first = nullptr;
+	other.lvl = 0;
+	other.size = 0;
+	other.blockCnt = 0;
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>& UnrolledSkipList<T, Alloc, LevelGen>::operator=(const UnrolledSkipList& other)
+{
+	if (&other != this) {
+		UnrolledSkipList<T, Alloc, LevelGen> newList(other);
+		*this = std::move(newList);
+	}
+	return *this;
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>& UnrolledSkipList<T, Alloc, LevelGen>::operator=(UnrolledSkipList&& other) noexcept
+{
+	if (&other != this) {
+		clearAll();
+		std::swap(other.first, first);
+		std::swap(other.fraction, fraction);
+		std::swap(other.MAXLVL, MAXLVL);
+		std::swap(other.lvl, lvl);
+		std::swap(other.size, size);
+		std::swap(other.blockCnt, blockCnt);
+		headerAlloc.swap(other.headerAlloc);
+		alloc.swap(other.alloc);
+		std::swap(other.levelGen, levelGen);
+	}
+	return *this;
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSkipList<T, Alloc, LevelGen>::~UnrolledSkipList() noexcept
+{
+	clearAll();
+	if (first) {
+		first->~Block();
+		headerAlloc.deallocate(first, Block::bytesFor((int)MAXLVL, 0));
+	}
+	first = nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+size_t UnrolledSkipList<T, Alloc, LevelGen>::getSize() const noexcept
+{
+	return size;
+}
+
+template <class T, class Alloc, class LevelGen>
+size_t UnrolledSkipList<T, Alloc, LevelGen>::getBlockCount() const noexcept
+{
+	return blockCnt;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool UnrolledSkipList<T, Alloc, LevelGen>::insert(const T& val)
+{
+	Block* prev[MAX_POSSIBLE_LVL + 1];
+	Block* b = findBlock(val);
+	if (b == first) {
+		//val is less than all values, it goes at the front of the first block
+		b = first->next[0];
+		if (!b) {
+			b = createBlock((int)randomLevel());//may throw, nothing is changed yet
+			b->values()[0] = val;
+			b->count = 1;
+			findPrev(val, prev);
+			link(b, prev);
+			++size;
+			return true;
+		}
+	}
+	T* values = b->values();
+	size_t pos = lowerIndex(values, b->count, val);
+	if (pos < b->count && !(val < values[pos])) return false;
+	if (b->count == BLOCK_CAP) {
+		//the upper half goes to a new block right after b
+		Block* n = createBlock((int)randomLevel());//may throw, nothing is changed yet
+		const size_t half = BLOCK_CAP / 2;
+		T* nValues = n->values();
+		std::move(values + half, values + BLOCK_CAP, nValues);
+		n->count = (unsigned short)(BLOCK_CAP - half);
+		b->count = (unsigned short)half;
+		findPrev(nValues[0], prev);
+		link(n, prev);
+		if (pos > half) {
+			b = n;
+			values = nValues;
+			pos -= half;
+		}
+	}
+	std::move_backward(values + pos, values + b->count, values + b->count + 1);
+	values[pos] = val;
+	++b->count;
+	++size;
+	return true;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool UnrolledSkipList<T, Alloc, LevelGen>::remove(const T& val) noexcept
+{
+	Block* prev[MAX_POSSIBLE_LVL + 1];
+	Block* b = findBlock(val);
+	if (b == first) return false;
+	T* values = b->values();
+	size_t pos = lowerIndex(values, b->count, val);
+	if (pos == b->count || val < values[pos]) return false;
+	--size;
+	if (b->count == 1) {
+		findPrev(values[0], prev);
+		unlink(b, prev);
+		destroyBlock(b);
+		return true;
+	}
+	std::move(values + pos + 1, values + b->count, values + pos);
+	--b->count;
+	Block* next = b->next[0];
+	if (b->count >= BLOCK_MIN || !next) return true;
+	T* nextValues = next->values();
+	if (b->count + next->count <= BLOCK_FILL) {
+		//merge: the values of next go at the end of b and next is deleted
+		findPrev(nextValues[0], prev);
+		std::move(nextValues, nextValues + next->count, values + b->count);
+		b->count += next->count;
+		unlink(next, prev);
+		destroyBlock(next);
+	}
+	else {
+		//take the smallest values of next, so both have about the same number.
+		//The smallest value of next grows, but stays less than the one of the block after it
+		size_t moved = (next->count - b->count) / 2;
+		std::move(nextValues, nextValues + moved, values + b->count);
+		std::move(nextValues + moved, nextValues + next->count, nextValues);
+		b->count += (unsigned short)moved;
+		next->count -= (unsigned short)moved;
+	}
+	return true;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool UnrolledSkipList<T, Alloc, LevelGen>::exists(const T& val) const noexcept
+{
+	const Block* b = findBlock(val);
+	if (b == first) return false;
+	const T* values = b->values();
+	size_t pos = lowerIndex(values, b->count, val);
+	return pos < b->count && !(val < values[pos]);
+}
+
+template <class T, class Alloc, class LevelGen>
+template <class It>
+bool UnrolledSkipList<T, Alloc, LevelGen>::buildFromSorted(It from, It to)
+{
+	//checking pass, so nothing is changed for wrong input
+	for (It prev = from, it = from; it != to; prev = it++) {
+		if (prev != it && !(*prev < *it)) return false;
+	}
+	UnrolledSkipList<T, Alloc, LevelGen> built(MAXLVL, fraction);
+	built.levelGen = levelGen;
+	//last block on each lvl
+	Block* tail[MAX_POSSIBLE_LVL + 1];
+	for (size_t i = 0; i <= built.MAXLVL; i++) {
+		tail[i] = built.first;
+	}
+	It it = from;
+	while (it != to) {
+		int rlevel = (int)built.randomLevel();
+		Block* b = built.createBlock(rlevel);//ok to throw, linked blocks are deleted with built
+		for (int i = 0; i <= rlevel; i++) {
+			tail[i]->next[i] = b;
+			tail[i] = b;
+		}
+		if ((size_t)rlevel > built.lvl) built.lvl = rlevel;
+		++built.blockCnt;
+		T* values = b->values();
+		for (; it != to && b->count < BLOCK_FILL; ++it) {
+			values[b->count++] = *it;
+			++built.size;
+		}
+	}
+	*this = std::move(built);
+	return true;
+}
+
+template <class T, class Alloc, class LevelGen>
+const T* UnrolledSkipList<T, Alloc, LevelGen>::lowerBound(const T& val) const noexcept
+{
+	const Block* b = findBlock(val);
+	size_t pos = 0;
+	if (b == first) b = first->next[0];
+	else pos = lowerIndex(b->values(), b->count, val);
+	//all values of b are less, the smallest of the next block is greater
+	if (b && pos == b->count) {
+		b = b->next[0];
+		pos = 0;
+	}
+	return b ? b->values() + pos : nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+const T* UnrolledSkipList<T, Alloc, LevelGen>::upperBound(const T& val) const noexcept
+{
+	const Block* b = findBlock(val);
+	size_t pos = 0;
+	if (b == first) b = first->next[0];
+	else {
+		pos = lowerIndex(b->values(), b->count, val);
+		//no repetitions, so only one value can be equal
+		if (pos < b->count && !(val < b->values()[pos])) ++pos;
+	}
+	if (b && pos == b->count) {
+		b = b->next[0];
+		pos = 0;
+	}
+	return b ? b->values() + pos : nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+template <class F>
+void UnrolledSkipList<T, Alloc, LevelGen>::forEachInRange(const T& lo, const T& hi, F f) const
+{
+	const Block* b = findBlock(lo);
+	size_t pos = 0;
+	if (b == first) b = first->next[0];
+	else pos = lowerIndex(b->values(), b->count, lo);
+	for (; b; b = b->next[0], pos = 0) {
+		const T* values = b->values();
+		for (; pos < b->count; pos++) {
+			if (!(values[pos] < hi)) return;
+			f(values[pos]);
+		}
+	}
+}
+
+template <class T, class Alloc, class LevelGen>
+void UnrolledSkipList<T, Alloc, LevelGen>::clearData() noexcept
+{
+	clearAll();
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSListIterator<T, Alloc, LevelGen> UnrolledSkipList<T, Alloc, LevelGen>::begin() const noexcept
+{
+	return UnrolledSListIterator<T, Alloc, LevelGen>(first ? first->next[0] : nullptr);
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSListIterator<T, Alloc, LevelGen> UnrolledSkipList<T, Alloc, LevelGen>::end() const noexcept
+{
+	return UnrolledSListIterator<T, Alloc, LevelGen>(nullptr);
+}
+
+template <class T, class Alloc, class LevelGen>
+size_t UnrolledSkipList<T, Alloc, LevelGen>::getBytesUsed() const noexcept
+{
+	return sizeof(*this) + headerAlloc.getBytesUsed() + alloc.getBytesUsed();
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSListIterator<T, Alloc, LevelGen>::UnrolledSListIterator(const typename UnrolledSkipList<T, Alloc, LevelGen>::Block* start) noexcept
+	: block(start), pos(0)
+{
+}
+
+template <class T, class Alloc, class LevelGen>
+UnrolledSListIterator<T, Alloc, LevelGen>& UnrolledSListIterator<T, Alloc, LevelGen>::operator++() noexcept
+{
+	if (block && ++pos == block->count) {
+		block = block->next[0];
+		pos = 0;
+	}
+	return *this;
+}
+
+template <class T, class Alloc, class LevelGen>
+const T* UnrolledSListIterator<T, Alloc, LevelGen>::operator*() const noexcept
+{
+	return block ? block->values() + pos : nullptr;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool UnrolledSListIterator<T, Alloc, LevelGen>::operator==(const UnrolledSListIterator& other) const noexcept
+{
+	return operator*() == *other;
+}
+
+template <class T, class Alloc, class LevelGen>
+bool UnrolledSListIterator<T, Alloc, LevelGen>::operator!=(const UnrolledSListIterator& other) const noexcept
+{
+	return operator*() != *other;
+}
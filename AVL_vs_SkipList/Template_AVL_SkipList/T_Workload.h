@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// @brief Kind of one workload operation
+enum class OpType { READ, INSERT, DELETE, SCAN };
+
+/// @brief How the records that operations go to are chosen
+enum class KeyDistribution {
+	/// @brief Every record is equally likely
+	UNIFORM,
+	/// @brief Few records get most of the operations (the oldest are the hottest)
+	ZIPFIAN,
+	/// @brief Records one after another, starting again from the first after the last
+	SEQUENTIAL,
+	/// @brief Zipfian over the age of the records: the newest inserted are the hottest
+	LATEST,
+	/// @brief Fixed part of the records gets a fixed part of the operations, uniform inside both parts
+	HOTSPOT
+};
+
+/// @brief One operation of a workload. hi is the end of the range for scans
+struct WorkloadOp {
+	OpType type;
+	int key;
+	int hi;
+};
+
+/// @brief Command line options as name - value pairs. Accepts "--name value" and "--name=value".
+/// "--config file" reads "name = value" lines from a file (# starts a comment), later options override earlier ones
+inline std::map<std::string, std::string> readOptions(int argc, char** argv)
+{
+	std::map<std::string, std::string> options;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.size() < 3 || arg[0] != '-' || arg[1] != '-') {
+			throw std::invalid_argument("Expected an option starting with --, got " + arg);
+		}
+		arg = arg.substr(2);
+		std::string name = arg, value;
+		size_t eq = arg.find('=');
+		if (eq != std::string::npos) {
+			name = arg.substr(0, eq);
+			value = arg.substr(eq + 1);
+		}
+		else if (i + 1 < argc) {
+			value = argv[++i];
+		}
+		else throw std::invalid_argument("Option --" + name + " needs a value");
+
+		if (name != "config") {
+			options[name] = value;
+			continue;
+		}
+		std::ifstream file(value);
+		if (!file) throw std::invalid_argument("Cannot open config file " + value);
+		std::string line;
+		while (std::getline(file, line)) {
+			line = line.substr(0, line.find('#'));
+			size_t sep = line.find('=');
+			if (sep == std::string::npos) {
+				if (line.find_first_not_of(" \t\r") != std::string::npos) {
+					throw std::invalid_argument("Expected name = value in " + value + ", got " + line);
+				}
+				continue;
+			}
+			auto trim = [](const std::string& s) {
+				size_t b = s.find_first_not_of(" \t\r"), e = s.find_last_not_of(" \t\r");
+				return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+			};
+			options[trim(line.substr(0, sep))] = trim(line.substr(sep + 1));
+		}
+	}
+	return options;
+}
+
+/// @brief Returns the number in the value of an option
+/// @throws std::invalid_argument if the value is not a number
+inline double optionNumber(const std::string& name, const std::string& value)
+{
+	size_t used = 0;
+	double result = 0;
+	try {
+		result = std::stod(value, &used);
+	}
+	catch (const std::exception&) {
+		used = 0;
+	}
+	if (!used || used != value.size()) throw std::invalid_argument("Option --" + name + " needs a number, got " + value);
+	return result;
+}
+
+/// @brief Settings of a mixed workload in the style of YCSB.
+/// keyCount records are loaded before the run, inserts add new records after them and
+/// reads, deletes and scans go to records chosen by the distribution
+struct WorkloadConfig {
+	/// @brief Parts of the operations of each kind. They do not have to sum to 1
+	double readRatio = 0.95, insertRatio = 0.05, deleteRatio = 0, scanRatio = 0;
+	KeyDistribution distribution = KeyDistribution::ZIPFIAN;
+	/// @brief Number of records loaded before the run
+	size_t keyCount = 100'000;
+	/// @brief Number of operations in the run
+	size_t opCount = 1'000'000;
+	/// @brief Expected number of values that one scan visits
+	size_t scanLength = 100;
+	/// @brief Skew of the zipfian and latest distributions. 0.99 as in YCSB
+	double zipfTheta = 0.99;
+	/// @brief Part of the records that is hot, and part of the operations that go to them
+	double hotSetFraction = 0.2, hotOpFraction = 0.8;
+	/// @brief Keys are the record numbers when true. Else records are spread over all non-negative ints
+	bool orderedKeys = false;
+	uint64_t seed = 1;
+
+	/// @brief Sets the setting with this option name. Returns false for unknown names
+	/// @throws std::invalid_argument for a value that is not valid for the setting
+	bool set(const std::string& name, const std::string& value)
+	{
+		if (name == "read") readRatio = optionNumber(name, value);
+		else if (name == "insert") insertRatio = optionNumber(name, value);
+		else if (name == "delete") deleteRatio = optionNumber(name, value);
+		else if (name == "scan") scanRatio = optionNumber(name, value);
+		else if (name == "keys") keyCount = (size_t)optionNumber(name, value);
+		else if (name == "ops") opCount = (size_t)optionNumber(name, value);
+		else if (name == "scanlen") scanLength = (size_t)optionNumber(name, value);
+		else if (name == "theta") zipfTheta = optionNumber(name, value);
+		else if (name == "hotset") hotSetFraction = optionNumber(name, value);
+		else if (name == "hotops") hotOpFraction = optionNumber(name, value);
+		else if (name == "ordered") orderedKeys = optionNumber(name, value) != 0;
+		else if (name == "seed") seed = (uint64_t)optionNumber(name, value);
+		else if (name == "dist") {
+			if (value == "uniform") distribution = KeyDistribution::UNIFORM;
+			else if (value == "zipfian") distribution = KeyDistribution::ZIPFIAN;
+			else if (value == "sequential") distribution = KeyDistribution::SEQUENTIAL;
+			else if (value == "latest") distribution = KeyDistribution::LATEST;
+			else if (value == "hotspot") distribution = KeyDistribution::HOTSPOT;
+			else throw std::invalid_argument("Unknown distribution " + value);
+		}
+		else return false;
+		return true;
+	}
+	/// @brief Checks that the settings can make a workload
+	/// @throws std::invalid_argument if they can not
+	void validate() const
+	{
+		if (readRatio < 0 || insertRatio < 0 || deleteRatio < 0 || scanRatio < 0 ||
+			readRatio + insertRatio + deleteRatio + scanRatio <= 0) {
+			throw std::invalid_argument("Operation ratios must be non-negative with a positive sum");
+		}
+		if (!keyCount) throw std::invalid_argument("At least one key must be loaded");
+		if (keyCount + opCount > (size_t)INT_MAX) throw std::invalid_argument("Keys and operations must fit in int");
+		if (zipfTheta <= 0 || zipfTheta >= 1) throw std::invalid_argument("Zipfian theta must be in (0, 1)");
+		if (hotSetFraction <= 0 || hotSetFraction > 1 || hotOpFraction < 0 || hotOpFraction > 1) {
+			throw std::invalid_argument("Hotspot fractions must be in (0, 1]");
+		}
+	}
+	/// @brief Returns the name of the distribution as it is given in the options
+	std::string distributionName() const
+	{
+		const char* names[] = { "uniform", "zipfian", "sequential", "latest", "hotspot" };
+		return names[(int)distribution];
+	}
+};
+
+/// @brief Zipfian generator of ranks in [0, n) after Gray et al. "Quickly generating billion-record synthetic databases"
+/// (the one YCSB uses). Rank 0 is the most likely. n may grow between draws, the zeta sum is extended for the new items only
+class ZipfianGenerator {
+private:
+	//data
+	double theta, alpha, zeta2;
+	/// @brief Sum of 1/i^theta for i from 1 to zetaCnt
+	double zetaN = 0;
+	uint64_t zetaCnt = 0;
+public:
+	explicit ZipfianGenerator(double theta) noexcept
+		: theta(theta), alpha(1 / (1 - theta)), zeta2(1 + std::pow(0.5, theta)) {}
+	/// @brief Returns a rank in [0, n) for a uniform u in [0, 1)
+	uint64_t operator()(uint64_t n, double u) noexcept
+	{
+		for (; zetaCnt < n; zetaCnt++) {
+			zetaN += 1 / std::pow((double)(zetaCnt + 1), theta);
+		}
+		if (n < 2) return 0;
+		double uz = u * zetaN;
+		if (uz < 1) return 0;
+		if (uz < zeta2) return 1;
+		double eta = (1 - std::pow(2.0 / (double)n, 1 - theta)) / (1 - zeta2 / zetaN);
+		uint64_t rank = (uint64_t)((double)n * std::pow(eta * u - eta + 1, alpha));
+		return rank < n ? rank : n - 1;
+	}
+};
+
+/// @brief Returns the key of a record. Unordered keys come from a bijection of the 31-bit numbers,
+/// so different records never share a key and neighbours in the structures are unrelated records
+inline int recordKey(uint64_t record, bool ordered) noexcept
+{
+	if (ordered) return (int)record;
+	const uint32_t MASK = 0x7FFFFFFFu;
+	uint32_t x = (uint32_t)record & MASK;
+	x = (x * 0x5BD1E995u) & MASK;
+	x ^= x >> 15;
+	x = (x * 0x27D4EB2Du) & MASK;
+	x ^= x >> 13;
+	return (int)x;
+}
+
+/// @brief Generator of the records and operations of a workload. Same config gives the same workload
+class WorkloadGenerator {
+private:
+	//data
+	WorkloadConfig config;
+	std::mt19937_64 rng;
+	std::uniform_real_distribution<double> unit{ 0.0, 1.0 };
+	ZipfianGenerator zipf;
+	/// @brief Number of records inserted so far, including the loaded ones
+	uint64_t recordCnt;
+	/// @brief Part of the workload that is generated and the number of parts (one for each thread)
+	uint64_t part, parts;
+	uint64_t nextSequential = 0;
+
+	//private methods
+	/// @brief Returns a record chosen by the distribution from the inserted ones
+	uint64_t chooseRecord()
+	{
+		switch (config.distribution) {
+		case KeyDistribution::ZIPFIAN:
+			return zipf(recordCnt, unit(rng));
+		case KeyDistribution::LATEST:
+			return recordCnt - 1 - zipf(recordCnt, unit(rng));
+		case KeyDistribution::SEQUENTIAL:
+			return nextSequential++ % recordCnt;
+		case KeyDistribution::HOTSPOT: {
+			uint64_t hotCnt = (uint64_t)((double)recordCnt * config.hotSetFraction);
+			if (!hotCnt) hotCnt = 1;
+			if (hotCnt == recordCnt || unit(rng) < config.hotOpFraction) return (uint64_t)(unit(rng) * (double)hotCnt);
+			return hotCnt + (uint64_t)(unit(rng) * (double)(recordCnt - hotCnt));
+		}
+		default:
+			return (uint64_t)(unit(rng) * (double)recordCnt);
+		}
+	}
+public:
+	/// @param part, parts For multithreaded runs: the generator makes opCount / parts operations of its own.
+	/// Its inserts take every parts-th new record starting from part, so different parts never insert the same key
+	/// @throws std::invalid_argument if the config is not valid
+	explicit WorkloadGenerator(const WorkloadConfig& config, unsigned part = 0, unsigned parts = 1)
+		: config(config), rng(config.seed + 0x9E3779B97F4A7C15ull * part), zipf(config.zipfTheta),
+		recordCnt(config.keyCount), part(part), parts(parts ? parts : 1)
+	{
+		config.validate();
+		if (part >= this->parts) throw std::invalid_argument("Part of the workload must be less than the number of parts");
+	}
+	/// @brief Returns the sorted keys of the records that are loaded before the run
+	std::vector<int> loadKeys() const
+	{
+		std::vector<int> keys(config.keyCount);
+		for (size_t i = 0; i < keys.size(); i++) {
+			keys[i] = recordKey(i, config.orderedKeys);
+		}
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+	/// @brief Returns the operations of the run in the order they are done. Kinds are mixed by their ratios
+	std::vector<WorkloadOp> operations()
+	{
+		const double total = config.readRatio + config.insertRatio + config.deleteRatio + config.scanRatio;
+		const double readEnd = config.readRatio / total;
+		const double insertEnd = readEnd + config.insertRatio / total;
+		const double deleteEnd = insertEnd + config.deleteRatio / total;
+		std::vector<WorkloadOp> ops(config.opCount / parts);
+		for (WorkloadOp& op : ops) {
+			double kind = unit(rng);
+			if (kind >= readEnd && kind < insertEnd) {
+				op.type = OpType::INSERT;
+				//the records of the other parts are counted as inserted at the same pace
+				op.key = recordKey(recordCnt + part, config.orderedKeys);
+				recordCnt += parts;
+				op.hi = op.key;
+				continue;
+			}
+			op.type = kind < readEnd ? OpType::READ : kind < deleteEnd ? OpType::DELETE : OpType::SCAN;
+			op.key = recordKey(chooseRecord(), config.orderedKeys);
+			op.hi = op.key;
+			if (op.type == OpType::SCAN) {
+				//keys of unordered records are spread over INT_MAX values, so the range is widened by their spacing
+				double width = (double)config.scanLength * (config.orderedKeys ? 1.0 : (double)INT_MAX / (double)recordCnt);
+				op.hi = (double)op.key + width < (double)INT_MAX ? op.key + (int)width : INT_MAX;
+			}
+		}
+		return ops;
+	}
+};
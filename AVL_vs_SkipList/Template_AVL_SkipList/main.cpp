@@ -1,13 +1,32 @@
 #include "T_AVLTree.h"
 #include "T_SkipList.h"
+#include "T_UnrolledSkipList.h"
+#include "T_BPlusTree.h"
+#include "T_LatencyHistogram.h"
+#include "T_BenchTimer.h"
+#include "T_Workload.h"
+#include "T_ConcurrentSkipList.h"
+#include "T_LockedSet.h"
+#include "T_ThreadPin.h"
+#include "T_PerfCounters.h"
+#include "T_BenchReport.h"
+#include "T_StdAdapters.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
 #include <chrono>
 //#include <unordered_set>
 #include <stdlib.h>     /* srand, rand */
+#if defined(_WIN32)
+#include <malloc.h>     /* _aligned_malloc */
+#endif
 #include <time.h> 
 #include <cmath>
 #include <string>
 #include <algorithm> 
 #include <random>
+#include <sstream>
 
 using std::chrono::steady_clock;
 using std::chrono::duration_cast;
@@ -22,331 +41,837 @@ int getOptimalLvlNum(int expectedSize, double p = 0.5) {
 	return log2(expectedSize) / log2(1 / p) + 1; //log(p^-1)N
 }
 
-#define SLIST_IND 0
-#define AVL_IND 1
+/// @brief Times, latencies and hardware events of one kind of operation on one structure
+struct OpStats {
+	/// @brief Sum of the block timed nanoseconds and the number of operations in them, the average is sum / timed
+	double sum = 0, timed = 0;
+	/// @brief Time of every operation timed alone
+	LatencyHistogram latency;
+	/// @brief Hardware events of the timed blocks
+	PerfCounters::Counts events;
+	/// @brief Average time per operation of each block timed repetition, for the confidence intervals
+	std::vector<double> samples;
+	/// @brief Sum and count when the current repetition started
+	double repStartSum = 0, repStartCnt = 0;
+
+	/// @brief Average time per operation of all timed blocks
+	double average() const { return timed > 0 ? sum / timed : 0; }
+	/// @brief Ends a block timed repetition: keeps its average time per operation as one sample
+	void endRepetition() {
+		samples.push_back((sum - repStartSum) / (timed - repStartCnt));
+		repStartSum = sum;
+		repStartCnt = timed;
+	}
+};
+
+/// @brief Results of one structure in a phases test
+struct StructureStats {
+	string name, shortName;
+	OpStats insertion, deletion, search;
+	/// @brief Bytes used when full, summed during the test and averaged at its end
+	double memory = 0;
+
+	void endRepetition() {
+		insertion.endRepetition();
+		deletion.endRepetition();
+		search.endRepetition();
+	}
+};
 
 struct TestHelperContainer {
-	struct TestHelper {
-		double insertion[2] = { 0 }, deletion[2] = { 0 }, search[2] = { 0 }, memory[2] = { 0 };
-	} avg, slowest;
+	/// @brief Results of every structure in the order they were given to the test
+	std::vector<StructureStats> structures;
+	/// @brief Counters read around every timed block. Null when they are not used
+	PerfCounters* counters = nullptr;
+
+	/// @brief Clock for all tests. Calibrated on the first use
+	static const BenchClock& clock() {
+		static const BenchClock benchClock;
+		return benchClock;
+	}
+
+	/// @brief Runs op(i) for i from 0 to n - 1.
+	/// A block run times all calls at once and adds them to the sum for the average (only the clock's cost
+	/// of one start and stop, which is subtracted) and counts its hardware events. Else every call is timed alone
+	/// with its clock cost subtracted and added to the histogram
+	template <class F>
+	void timeOps(OpStats& stats, int n, bool block, F op) {
+		const BenchClock& c = clock();
+		if (block) {
+			if (counters) counters->start();
+			stats.sum += c.timeBlock(n, op) * n;
+			if (counters) stats.events += counters->stop();
+			stats.timed += n;
+			return;
+		}
+		for (int i = 0; i < n; i++) {
+			uint64_t t = c.start();
+			op(i);
+			stats.latency.record((uint64_t)(c.toNs(c.stop() - t) + 0.5));
+		}
+	}
 };
 
-#pragma optimize( "", off )
-TestHelperContainer findAvgInsertDelFind(const unsigned elemCnt, const int testsCnt = 30) {
+/// @brief Results of running a workload on one structure
+struct WorkloadResult {
+	/// @brief Time of every operation, by OpType
+	LatencyHistogram latency[4];
+	double opsPerSec = 0;
+	size_t memory = 0;
+};
+
+/// @brief Does one workload operation. Returns if it found/changed a value, the number of visited values for scans
+template <class Structure>
+size_t applyOp(Structure& s, const WorkloadOp& op) {
+	switch (op.type) {
+	case OpType::READ: return s.exists(op.key);
+	case OpType::INSERT: return s.insert(op.key);
+	case OpType::DELETE: return s.remove(op.key);
+	default: {
+		size_t seen = 0;
+		s.forEachInRange(op.key, op.hi, [&](const int&) { seen++; });
+		return seen;
+	}
+	}
+}
+
+/// @brief Loads the keys and runs the operations two times: once timed as a block for the throughput,
+/// once timing every operation for the percentiles
+template <class Structure>
+WorkloadResult runWorkload(Structure& s, const std::vector<int>& keys, const std::vector<WorkloadOp>& ops) {
+	WorkloadResult result;
+	const BenchClock& c = TestHelperContainer::clock();
+	size_t done = 0;
+	s.buildFromSorted(keys.begin(), keys.end());
+	double ns = c.timeBlock(ops.size(), [&](size_t i) { done += applyOp(s, ops[i]); });
+	result.opsPerSec = ns > 0 ? 1e9 / ns : 0;
+	result.memory = s.getBytesUsed();
+	s.buildFromSorted(keys.begin(), keys.end());
+	for (const WorkloadOp& op : ops) {
+		uint64_t t = c.start();
+		done += applyOp(s, op);
+		result.latency[(int)op.type].record((uint64_t)(c.toNs(c.stop() - t) + 0.5));
+	}
+	keepValue(done);
+	return result;
+}
+
+/// @brief A structure compared by the tests. There is one virtual call for each timed phase: the operations
+/// inside it are called on the real type, so every structure is timed without the cost of a virtual call
+class Contender {
+public:
+	/// @brief Name in the tables and the saved results and a short one for the rows of the percentile tables
+	const string name, shortName;
+
+	Contender(const string& name, const string& shortName) : name(name), shortName(shortName) {}
+	virtual ~Contender() = default;
+	/// @brief Inserts keys[0] to keys[n - 1], timed with data.timeOps()
+	virtual void insert(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) = 0;
+	/// @brief Removes keys[0] to keys[n - 1], timed with data.timeOps()
+	virtual void remove(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) = 0;
+	/// @brief Looks up keys[0] to keys[n - 1], timed with data.timeOps()
+	virtual void search(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) = 0;
+	/// @brief Inserts keys[0] to keys[n - 1] without timing them
+	virtual void fill(const int* keys, int n) = 0;
+	virtual size_t getBytesUsed() const = 0;
+	virtual void clearData() = 0;
+	/// @brief Runs a workload with runWorkload()
+	virtual WorkloadResult workload(const std::vector<int>& keys, const std::vector<WorkloadOp>& ops) = 0;
+};
+
+/// @brief Contender for any structure with insert, remove, exists, getBytesUsed, clearData,
+/// forEachInRange and buildFromSorted
+template <class Structure>
+class ContenderOf : public Contender {
+private:
+	//data
+	std::unique_ptr<Structure> s;
+public:
+	ContenderOf(const string& name, const string& shortName, Structure* s) : Contender(name, shortName), s(s) {}
+	void insert(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) override {
+		Structure& st = *s;
+		data.timeOps(stats, n, block, [&](int i) { st.insert(keys[i]); });
+	}
+	void remove(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) override {
+		Structure& st = *s;
+		data.timeOps(stats, n, block, [&](int i) { st.remove(keys[i]); });
+	}
+	void search(TestHelperContainer& data, OpStats& stats, const int* keys, int n, bool block) override {
+		Structure& st = *s;
+		data.timeOps(stats, n, block, [&](int i) { keepValue(st.exists(keys[i])); });
+	}
+	void fill(const int* keys, int n) override {
+		for (int i = 0; i < n; i++) {
+			s->insert(keys[i]);
+		}
+	}
+	size_t getBytesUsed() const override { return s->getBytesUsed(); }
+	void clearData() override { s->clearData(); }
+	WorkloadResult workload(const std::vector<int>& keys, const std::vector<WorkloadOp>& ops) override {
+		return runWorkload(*s, keys, ops);
+	}
+};
+
+typedef std::vector<std::unique_ptr<Contender>> Contenders;
+
+/// @brief Structures that can be compared, in the order of the tables
+const char* STRUCTURE_NAMES = "avl,skiplist,unrolled,btree,set,uset,vector";
+
+/// @brief Makes the structures named in a comma separated list (from STRUCTURE_NAMES) for about expectedSize values
+Contenders makeContenders(const string& names, int expectedSize) {
+	Contenders contenders;
+	std::stringstream list(names);
+	string name;
+	while (std::getline(list, name, ',')) {
+		Contender* c = nullptr;
+		if (name == "avl") c = new ContenderOf<AVLTree<int>>("AVL", "AVL", new AVLTree<int>());
+		else if (name == "skiplist") c = new ContenderOf<SkipList<int>>("SkipList", "SL", new SkipList<int>(getOptimalLvlNum(expectedSize), 0.5));
+		//the lvls index blocks of about 16 values
+		else if (name == "unrolled") c = new ContenderOf<UnrolledSkipList<int>>("Unrolled SL", "USL", new UnrolledSkipList<int>(getOptimalLvlNum(expectedSize / 16 + 1), 0.5));
+		else if (name == "btree") c = new ContenderOf<BPlusTree<int>>("B+Tree", "B+", new BPlusTree<int>());
+		else if (name == "set") c = new ContenderOf<StdSetAdapter<int>>("std::set", "set", new StdSetAdapter<int>());
+		else if (name == "uset") c = new ContenderOf<UnorderedSetAdapter<int>>("unordered_set", "uset", new UnorderedSetAdapter<int>());
+		else if (name == "vector") c = new ContenderOf<SortedVectorAdapter<int>>("sorted vector", "vec", new SortedVectorAdapter<int>());
+		else throw std::invalid_argument("Unknown structure " + name + ", expected some of " + STRUCTURE_NAMES);
+		contenders.emplace_back(c);
+		for (size_t i = 0; i + 1 < contenders.size(); i++) {
+			if (contenders[i]->name == c->name) throw std::invalid_argument("Structure " + name + " is given two times");
+		}
+	}
+	if (contenders.empty()) throw std::invalid_argument("No structures to compare");
+	return contenders;
+}
+
+/// @brief Makes the results of a phases test for the structures
+TestHelperContainer newTestData(const Contenders& contenders, PerfCounters* counters) {
 	TestHelperContainer data;
-	//std::unordered_set<int> set;
+	data.counters = counters;
+	for (const auto& c : contenders) {
+		StructureStats stats;
+		stats.name = c->name;
+		stats.shortName = c->shortName;
+		data.structures.push_back(stats);
+	}
+	return data;
+}
+
+#pragma optimize( "", off )
+TestHelperContainer findAvgInsertDelFind(const Contenders& contenders, const unsigned elemCnt, const int testsCnt = 30, const unsigned seed = 0, PerfCounters* counters = nullptr) {
+	TestHelperContainer data = newTestData(contenders, counters);
 	int* arr = new int[elemCnt];
 	//
 	for (int i = 0; i < elemCnt; i++) {
 		arr[i] = i;
 	}
-	//
-	int value;
-	const int intMax = ~(1 << (sizeof(int) * 8 - 1));
-	SkipList<int> list(getOptimalLvlNum(elemCnt), 0.5);
-	AVLTree<int> tree;
-
 	//
 	for (int j = 0; j < testsCnt; j++) {
-		//std::cout << j;
-		unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-		std::shuffle(arr, arr + elemCnt, std::default_random_engine(seed));
+		//every structure gets the same order of values
+		std::shuffle(arr, arr + elemCnt, std::default_random_engine(seed + j));
+		//even repetitions time blocks for the averages, odd ones single operations for the percentiles
+		bool block = j % 2 == 0;
 		//insert
-		auto start = steady_clock::now();
-		auto end = steady_clock::now();
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-			list.insert(arr[i]);
-			end = steady_clock::now();
-			data.avg.insertion[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.insertion[SLIST_IND])
-				data.slowest.insertion[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
-		}
-
-		//data.insertion[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-		data.avg.memory[SLIST_IND] += list.getBytesUsed();
-		if (list.getBytesUsed() > data.slowest.memory[SLIST_IND]) {
-			data.slowest.memory[SLIST_IND] = list.getBytesUsed();
+		for (size_t k = 0; k < contenders.size(); k++) {
+			contenders[k]->insert(data, data.structures[k].insertion, arr, elemCnt, block);
+			data.structures[k].memory += contenders[k]->getBytesUsed();
 		}
-		//AVL insert
-
-
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-			tree.insert(arr[i]);
-			end = steady_clock::now();
-			data.avg.insertion[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.insertion[AVL_IND])
-				data.slowest.insertion[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
-		}
-		//
-
-		data.avg.memory[AVL_IND] += tree.getBytesUsed();
-		if (tree.getBytesUsed() > data.slowest.memory[AVL_IND]) {
-			data.slowest.memory[AVL_IND] = tree.getBytesUsed();
+		//find
+		for (size_t k = 0; k < contenders.size(); k++) {
+			contenders[k]->search(data, data.structures[k].search, arr, elemCnt, block);
 		}
-		//List find
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-			list.exists(arr[i]);
-
-			end = steady_clock::now();
-			data.avg.search[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.search[SLIST_IND])
-				data.slowest.search[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
-		}
-		//std::cout << "Height :" <<tree.getHeight() << std::endl;
-		//tree find
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-
-			tree.exists(arr[i]);
-
-			end = steady_clock::now();
-			data.avg.search[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.search[AVL_IND])
-				data.slowest.search[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
-		}
-		//List delete
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-			list.remove(arr[i]);
-
-			end = steady_clock::now();
-			data.avg.deletion[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.deletion[SLIST_IND])
-				data.slowest.deletion[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
-		}
-		//tree delete
-
-		for (int i = 0; i < elemCnt; i++) {
-			start = steady_clock::now();
-
-			tree.remove(arr[i]);
-
-			end = steady_clock::now();
-			data.avg.deletion[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-			if (duration_cast<nanoseconds>(end - start).count() >
-				data.slowest.deletion[AVL_IND])
-				data.slowest.deletion[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
+		//delete
+		for (size_t k = 0; k < contenders.size(); k++) {
+			contenders[k]->remove(data, data.structures[k].deletion, arr, elemCnt, block);
 		}
 		//clear data
-		tree.clearData();
-		list.clearData();
-		//set.clear();
+		for (size_t k = 0; k < contenders.size(); k++) {
+			if (block) data.structures[k].endRepetition();
+			contenders[k]->clearData();
+		}
 	}
 	delete[] arr;
-	for (int i = 0; i < 2; i++) {
-		data.avg.insertion[i] /= (testsCnt * elemCnt);
-		data.avg.deletion[i] /= (testsCnt * elemCnt);
-		data.avg.search[i] /= (testsCnt * elemCnt);
-		data.avg.memory[i] /= (testsCnt);// *elemCnt);
+	for (StructureStats& s : data.structures) {
+		s.memory /= testsCnt;
 	}
-
 	return data;
 }
 
 #pragma optimize( "", off )
-TestHelperContainer findAvgWhenWorkingWithManyElements(const unsigned elemCnt, const int testsCnt = 30)
+TestHelperContainer findAvgWhenWorkingWithManyElements(const Contenders& contenders, const unsigned elemCnt, const int testsCnt = 30, const unsigned seed = 0, PerfCounters* counters = nullptr)
 {
-	TestHelperContainer data;
-	
+	TestHelperContainer data = newTestData(contenders, counters);
 	int* arr = new int[elemCnt];
 	//
 	for (int i = 0; i < elemCnt; i++) {
 		arr[i] = i;
 	}
 	//
-	int value;
-
-	SkipList<int> list(getOptimalLvlNum(elemCnt), 0.5);
-	AVLTree<int> tree;
-	size_t cnt = 0;
-	//
 	for (int j = 0; j < testsCnt; j++) {
-		unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-		std::shuffle(arr, arr + elemCnt, std::default_random_engine(seed));
-		//insert
-		auto start = steady_clock::now();
-		auto end = steady_clock::now();
-		for (int i = 0; i < elemCnt; i++) {
-			list.insert(arr[i]);
-		}
-
-		for (int i = 0; i < elemCnt; i++) {
-			tree.insert(arr[i]);
+		std::shuffle(arr, arr + elemCnt, std::default_random_engine(seed + j));
+		//even repetitions time blocks for the averages, odd ones single operations for the percentiles
+		bool block = j % 2 == 0;
+		for (const auto& c : contenders) {
+			c->fill(arr, elemCnt);
 		}
 
 		//now we use operation while we stay with many elements in the structures
 		for (int i2 = 0; i2 < 15; i2++) {
-
 			int cntOfEl = (2 + rand() % 10) * (elemCnt / 100);
-			cnt += cntOfEl;
 			//now remove them
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
-				list.remove(arr[i]);
-				end = steady_clock::now();
-				data.avg.deletion[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.deletion[SLIST_IND])
-					data.slowest.deletion[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
-			}
-			//avl
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
-				tree.remove(arr[i]);
-				end = steady_clock::now();
-				data.avg.deletion[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.deletion[AVL_IND])
-					data.slowest.deletion[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
+			for (size_t k = 0; k < contenders.size(); k++) {
+				contenders[k]->remove(data, data.structures[k].deletion, arr, cntOfEl, block);
 			}
 			//and and add again
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
-				list.insert(arr[i]);
-				end = steady_clock::now();
-				data.avg.insertion[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.insertion[SLIST_IND])
-					data.slowest.insertion[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
+			for (size_t k = 0; k < contenders.size(); k++) {
+				contenders[k]->insert(data, data.structures[k].insertion, arr, cntOfEl, block);
 			}
-
-			//AVL insert
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
-				tree.insert(arr[i]);
-				end = steady_clock::now();
-				data.avg.insertion[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.insertion[AVL_IND])
-					data.slowest.insertion[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
+			//find
+			for (size_t k = 0; k < contenders.size(); k++) {
+				contenders[k]->search(data, data.structures[k].search, arr, cntOfEl, block);
+				data.structures[k].memory += contenders[k]->getBytesUsed();
 			}
-			//
-			//List find
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
-				list.exists(arr[i]);
-
-				end = steady_clock::now();
-				data.avg.search[SLIST_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.search[SLIST_IND])
-					data.slowest.search[SLIST_IND] = duration_cast<nanoseconds>(end - start).count();
-			}
-			//tree find
-			for (int i = 0; i < cntOfEl; i++) {
-				start = steady_clock::now();
+		}
 
-				tree.exists(arr[i]);
+		for (size_t k = 0; k < contenders.size(); k++) {
+			if (block) data.structures[k].endRepetition();
+			contenders[k]->clearData();
+		}
+	}
+	delete[] arr;
+	for (StructureStats& s : data.structures) {
+		s.memory /= testsCnt;
+	}
+	return data;
+}
 
-				end = steady_clock::now();
-				data.avg.search[AVL_IND] += duration_cast<nanoseconds>(end - start).count();
-				if (duration_cast<nanoseconds>(end - start).count() >
-					data.slowest.search[AVL_IND])
-					data.slowest.search[AVL_IND] = duration_cast<nanoseconds>(end - start).count();
-			}
-			data.avg.memory[AVL_IND] += tree.getBytesUsed();
-			if (tree.getBytesUsed() > data.slowest.memory[AVL_IND]) {
-				data.slowest.memory[AVL_IND] = tree.getBytesUsed();
+/// @brief Prints the average time of each operation and the memory of every structure, then the same
+/// in percent of std::set (of the first structure when std::set is not compared)
+void printPrettyTable(const TestHelperContainer& data, const string starter = "__________") {
+	const int colWidth = 14;
+	const string rows[] = { "Insertion ", "Deletion  ", "Search    ", "Memory    " };
+	const std::vector<StructureStats>& structures = data.structures;
+	auto values = [](const StructureStats& s) {
+		std::vector<double> v = { s.insertion.average(), s.deletion.average(), s.search.average(), s.memory };
+		return v;
+	};
+	size_t reference = 0;
+	for (size_t i = 0; i < structures.size(); i++) {
+		if (structures[i].name == "std::set") reference = i;
+	}
+	const string line = string(11 + structures.size() * (colWidth + 1), '-') + "\n";
+	for (int percent = 0; percent < (structures.size() > 1 ? 2 : 1); percent++) {
+		if (percent) std::cout << "In percent of " << structures[reference].name << ":\n";
+		std::cout << line << starter << "|";
+		for (const StructureStats& s : structures) {
+			size_t left = (colWidth - s.name.size()) / 2;
+			std::cout << string(left, ' ') << s.name << string(colWidth - s.name.size() - left, ' ') << "|";
+		}
+		std::cout << "\n";
+		const std::vector<double> base = values(structures[reference]);
+		for (int row = 0; row < 4; row++) {
+			std::cout << rows[row] << "|";
+			for (const StructureStats& s : structures) {
+				double v = values(s)[row];
+				string val = percent ? std::to_string((long long)(base[row] > 0 ? v * 100 / base[row] : 0)) + "%" :
+					std::to_string((long long)v) + (row == 3 ? "b" : "ns");
+				std::cout << string(colWidth - val.size(), ' ') << val << "|";
 			}
-			data.avg.memory[SLIST_IND] += list.getBytesUsed();
-			if (list.getBytesUsed() > data.slowest.memory[SLIST_IND]) {
-				data.slowest.memory[SLIST_IND] = list.getBytesUsed();
+			std::cout << "\n";
+		}
+		std::cout << line;
+	}
+}
+
+void printLatencyRow(const string& name, const LatencyHistogram& hist) {
+	const double percentiles[] = { 50, 90, 99, 99.9 };
+	const int colWidth = 9;
+	std::cout << name << std::string(10 - name.size(), ' ') << "|";
+	for (double p : percentiles) {
+		string val = std::to_string(hist.valueAtPercentile(p));
+		std::cout << std::string(colWidth - val.size(), ' ') << val << "ns|";
+	}
+	string val = std::to_string(hist.getMax());
+	std::cout << std::string(colWidth + 2 - val.size(), ' ') << val << "ns|\n";
+}
+
+void printLatencyTable(const TestHelperContainer& data) {
+	std::cout << "-------------------------------------------------------------------\n";
+	std::cout << "__________|     p50   |     p90   |     p99   |   p99.9   |      max    |\n";
+	for (const StructureStats& s : data.structures) {
+		printLatencyRow(s.shortName + " ins", s.insertion.latency);
+	}
+	for (const StructureStats& s : data.structures) {
+		printLatencyRow(s.shortName + " del", s.deletion.latency);
+	}
+	for (const StructureStats& s : data.structures) {
+		printLatencyRow(s.shortName + " find", s.search.latency);
+	}
+	std::cout << "-------------------------------------------------------------------\n";
+}
+
+void printEventsRow(const string& name, const PerfCounters& counters, const OpStats& stats) {
+	const int colWidth = 10;
+	const PerfCounters::Counts& events = stats.events;
+	const double ops = stats.timed;
+	std::cout << name << std::string(10 - name.size(), ' ') << "|";
+	for (int e = 0; e < PerfCounters::EVENT_CNT; e++) {
+		string val = "-";
+		if (counters.has((PerfCounters::Event)e) && ops > 0) {
+			val = std::to_string((double)events.values[e] / ops);
+			val = val.substr(0, val.find('.') + (val.find('.') > 4 ? 0 : 3));
+		}
+		std::cout << std::string(colWidth - val.size(), ' ') << val << "|";
+		if (e == PerfCounters::INSTRUCTIONS) {
+			//instructions per cycle
+			val = "-";
+			if (counters.has(PerfCounters::CYCLES) && counters.has(PerfCounters::INSTRUCTIONS) && events.values[PerfCounters::CYCLES]) {
+				val = std::to_string((double)events.values[PerfCounters::INSTRUCTIONS] / (double)events.values[PerfCounters::CYCLES]).substr(0, 4);
 			}
+			std::cout << std::string(6 - val.size(), ' ') << val << "|";
 		}
+	}
+	std::cout << "\n";
+}
 
-		//List find
-		tree.clearData();
-		list.clearData();
-		//set.clear();
+/// @brief Prints the hardware events per operation of the timed blocks
+void printEventsTable(const TestHelperContainer& data) {
+	const PerfCounters& counters = *data.counters;
+	std::cout << "----------------------------------------------------------------------------------------\n";
+	std::cout << "per op    |    cycles|     instr|   IPC|  L1d miss|  LLC miss| dTLB miss|   br miss|\n";
+	for (const StructureStats& s : data.structures) {
+		printEventsRow(s.shortName + " ins", counters, s.insertion);
 	}
-	delete[] arr;
-	for (int i = 0; i < 2; i++) {
-		data.avg.insertion[i] /= cnt;//(testsCnt * cnt);
-		data.avg.deletion[i] /= cnt;
-		data.avg.search[i] /= cnt;
-		data.avg.memory[i] /= (testsCnt);// *elemCnt);
+	for (const StructureStats& s : data.structures) {
+		printEventsRow(s.shortName + " del", counters, s.deletion);
+	}
+	for (const StructureStats& s : data.structures) {
+		printEventsRow(s.shortName + " find", counters, s.search);
 	}
+	std::cout << "----------------------------------------------------------------------------------------\n";
+}
 
-	return data;
+void printWorkloadTable(const Contenders& contenders, const std::vector<WorkloadResult>& results) {
+	std::cout << "---------------------------------------------------\n";
+	std::cout << "______________|      ops/s     |     memory     |\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const string& name = contenders[i]->name;
+		string ops = std::to_string((long long)results[i].opsPerSec);
+		string mem = std::to_string(results[i].memory);
+		std::cout << name << std::string(14 - name.size(), ' ') << "|" <<
+			std::string(16 - ops.size(), ' ') << ops << "|" <<
+			std::string(15 - mem.size(), ' ') << mem << "b|\n";
+	}
+	std::cout << "---------------------------------------------------\n";
+	std::cout << "\nLatency percentiles by operation kind.\n";
+	std::cout << "-------------------------------------------------------------------\n";
+	std::cout << "__________|     p50   |     p90   |     p99   |   p99.9   |      max    |\n";
+	const string kinds[] = { " read", " ins", " del", " scan" };
+	for (int kind = 0; kind < 4; kind++) {
+		if (!results[0].latency[kind].getCount()) continue;
+		for (size_t i = 0; i < results.size(); i++) {
+			printLatencyRow(contenders[i]->shortName + kinds[kind], results[i].latency[kind]);
+		}
+	}
+	std::cout << "-------------------------------------------------------------------\n";
 }
 
-void printPrettyTable(TestHelperContainer::TestHelper& data, const string starter = "__________") {
-	string avlData[] = { std::to_string((int)data.insertion[AVL_IND]) ,
-					   std::to_string((int)data.deletion[AVL_IND]) ,
-					   std::to_string((int)data.search[AVL_IND]),
-					   std::to_string((int)data.memory[AVL_IND]) };
-	string slData[] = { std::to_string((int)data.insertion[SLIST_IND]) ,
-					   std::to_string((int)data.deletion[SLIST_IND]) ,
-					   std::to_string((int)data.search[SLIST_IND]),
-					   std::to_string((int)data.memory[SLIST_IND]) };
-	const int firstColWidth = 10;//insertion,del,search -  "(in ns)"
-	const int otherColsWidth = 10;
-	string percentComp[] = { std::to_string(((int)data.insertion[AVL_IND]) * 100 / ((int)data.insertion[SLIST_IND])) ,
-					  std::to_string(((int)data.deletion[AVL_IND]) * 100 / ((int)data.deletion[SLIST_IND])) ,
-					  std::to_string(((int)data.search[AVL_IND]) * 100 / ((int)data.search[SLIST_IND])),
-					  std::to_string(((int)data.memory[AVL_IND]) * 100 / ((int)data.memory[SLIST_IND])) };
-	//row 1
-	std::cout << "-----------------------------------------------\n";
-	//string(firstColWidth, ' ')
-	std::cout << starter << "|     AVL    |  SkipList  |  AVL/SL  |\n";
-	//row 2
-	std::cout << "Insertion |" << //first col
-		std::string(otherColsWidth - avlData[0].size(), ' ') << avlData[0] << "ns|" << //second col
-		std::string(otherColsWidth - slData[0].size(), ' ') << slData[0] << "ns|" << //third
-		std::string(otherColsWidth - percentComp[0].size() - 1, ' ') << percentComp[0] << "%|" << std::endl; //forth
-	//row 3
-	std::cout << "Deletion  |" << //first col
-		std::string(otherColsWidth - avlData[1].size(), ' ') << avlData[1] << "ns|" << //second col
-		std::string(otherColsWidth - slData[1].size(), ' ') << slData[1] << "ns|" << //third
-		std::string(otherColsWidth - percentComp[1].size() - 1, ' ') << percentComp[1] << "%|" << std::endl; //forth
-	//row 3
-	std::cout << "Search    |" << //first col
-		std::string(otherColsWidth - avlData[2].size(), ' ') << avlData[2] << "ns|" << //second col
-		std::string(otherColsWidth - slData[2].size(), ' ') << slData[2] << "ns|" << //third
-		std::string(otherColsWidth - percentComp[2].size() - 1, ' ') << percentComp[2] << "%|" << std::endl; //forth
-	std::cout << "Memory    |" << //first col
-		std::string(otherColsWidth - avlData[3].size() + 1, ' ') << avlData[3] << "b|" << //second col
-		std::string(otherColsWidth - slData[3].size() + 1, ' ') << slData[3] << "b|" << //third
-		std::string(otherColsWidth - percentComp[3].size() - 1, ' ') << percentComp[3] << "%|" << std::endl; //forth
-	std::cout << "-----------------------------------------------\n";
+/// @brief Runs one mixed workload on every structure and prints the results
+void runWorkloadMode(const WorkloadConfig& config, const string& structures) {
+	WorkloadGenerator generator(config);
+	const std::vector<int> keys = generator.loadKeys();
+	const std::vector<WorkloadOp> ops = generator.operations();
+	const double total = config.readRatio + config.insertRatio + config.deleteRatio + config.scanRatio;
+	std::cout << "Workload: " << config.readRatio * 100 / total << "% read, " << config.insertRatio * 100 / total << "% insert, " <<
+		config.deleteRatio * 100 / total << "% delete, " << config.scanRatio * 100 / total << "% scan (" << config.scanLength << " values)\n";
+	std::cout << config.distributionName() << " keys, " << config.keyCount << " loaded, " << config.opCount << " operations, seed " << config.seed << "\n";
+	std::cout << "Clock: " << (TestHelperContainer::clock().usesTsc() ? "rdtsc" : "steady_clock")
+		<< ", own cost " << TestHelperContainer::clock().getOverheadNs() << "ns (subtracted)\n\n";
+
+	Contenders contenders = makeContenders(structures, (int)(config.keyCount + config.opCount * config.insertRatio / total) + 1);
+	std::vector<WorkloadResult> results;
+	for (const auto& c : contenders) {
+		results.push_back(c->workload(keys, ops));
+	}
+	printWorkloadTable(contenders, results);
 }
 
+/// @brief Results of running a workload on many threads
+struct ThreadedResult {
+	double opsPerSec = 0;
+	/// @brief Time of every operation of all threads
+	LatencyHistogram latency;
+	/// @brief Highest p99 of a single thread
+	uint64_t worstThreadP99 = 0;
+};
+
+/// @brief Loads the sorted keys to a structure
+template <class Structure>
+void loadKeys(Structure& s, const std::vector<int>& keys) {
+	s.buildFromSorted(keys.begin(), keys.end());
+}
 
+/// @brief Loads the sorted keys to a concurrent list, which has no bulk load
+template <class T>
+void loadKeys(ConcurrentSkipList<T>& s, const std::vector<int>& keys) {
+	for (int key : keys) {
+		s.insert(key);
+	}
+}
 
-int main() {
-	srand(time(NULL));
+/// @brief Frees a block of alignedNew
+inline void alignedFree(void* block) noexcept {
+#if defined(_WIN32)
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+/// @brief Destroys a structure made with alignedNew
+template <class Structure>
+struct AlignedDelete {
+	void operator()(Structure* s) const noexcept {
+		s->~Structure();
+		alignedFree(s);
+	}
+};
+
+/// @brief Creates a structure on a block with its own alignment. Sharded and concurrent structures keep their
+/// locks and thread slots on own cache lines (alignas(64)), which new does not respect before C++17
+template <class Structure, class... Args>
+Structure* alignedNew(const Args&... args) {
+	const size_t alignment = std::max(alignof(Structure), sizeof(void*));
+#if defined(_WIN32)
+	void* block = _aligned_malloc(sizeof(Structure), alignment);
+#else
+	void* block = nullptr;
+	if (posix_memalign(&block, alignment, sizeof(Structure)) != 0) block = nullptr;
+#endif
+	if (!block) throw std::bad_alloc();
 	try {
-		const int testNum = 30;
-		const int elemCnt = 1'000;
+		return new (block) Structure(args...);
+	}
+	catch (...) {
+		alignedFree(block);
+		throw;
+	}
+}
+
+/// @brief Runs the operations of each thread at the same time on one structure made with create() (by alignedNew),
+/// thread i pinned to processor i. Runs two times on new structures: first untimed inside for the throughput
+/// (wall time of all threads), then timing every operation for the latencies
+template <class Structure, class Create>
+ThreadedResult runThreaded(Create create, const std::vector<int>& keys, const std::vector<std::vector<WorkloadOp>>& ops) {
+	ThreadedResult result;
+	const BenchClock& c = TestHelperContainer::clock();
+	const unsigned threadCnt = (unsigned)ops.size();
+	std::vector<LatencyHistogram> latency(threadCnt);
+	std::vector<std::exception_ptr> errors(threadCnt);
+	size_t opCnt = 0;
+	for (const auto& threadOps : ops) {
+		opCnt += threadOps.size();
+	}
+	for (int pass = 0; pass < 2; pass++) {
+		std::unique_ptr<Structure, AlignedDelete<Structure>> s(create());
+		loadKeys(*s, keys);
+		std::atomic<unsigned> ready{ 0 };
+		std::atomic<bool> go{ false };
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < threadCnt; t++) {
+			threads.emplace_back([&, t]() {
+				try {
+					pinThisThread(t);
+					size_t done = 0;
+					ready++;
+					//all threads start together
+					while (!go.load()) std::this_thread::yield();
+					if (pass == 0) {
+						for (const WorkloadOp& op : ops[t]) {
+							done += applyOp(*s, op);
+						}
+					}
+					else {
+						for (const WorkloadOp& op : ops[t]) {
+							uint64_t time = c.start();
+							done += applyOp(*s, op);
+							latency[t].record((uint64_t)(c.toNs(c.stop() - time) + 0.5));
+						}
+					}
+					keepValue(done);
+				}
+				catch (...) {
+					errors[t] = std::current_exception();
+				}
+			});
+		}
+		while (ready.load() < threadCnt) std::this_thread::yield();
+		steady_clock::time_point begin = steady_clock::now();
+		go.store(true);
+		for (std::thread& th : threads) {
+			th.join();
+		}
+		double ns = (double)duration_cast<nanoseconds>(steady_clock::now() - begin).count();
+		for (const std::exception_ptr& error : errors) {
+			if (error) std::rethrow_exception(error);
+		}
+		if (pass == 0) result.opsPerSec = ns > 0 ? (double)opCnt * 1e9 / ns : 0;
+	}
+	for (const LatencyHistogram& threadLatency : latency) {
+		result.latency.merge(threadLatency);
+		result.worstThreadP99 = std::max(result.worstThreadP99, threadLatency.valueAtPercentile(99));
+	}
+	return result;
+}
+
+/// @brief Runs the workload of every thread count on structures made with create() and prints one row for each count
+template <class Structure, class Create>
+void printScaling(const string& name, Create create, const std::vector<int>& keys,
+	const std::vector<std::vector<std::vector<WorkloadOp>>>& opsByThreadCnt) {
+	std::cout << "\n" << name << "\n";
+	std::cout << "---------------------------------------------------------------------------\n";
+	std::cout << "threads   |      ops/s     | speedup |     p50   |     p99   | worst thread p99 |\n";
+	double single = 0;
+	for (const auto& ops : opsByThreadCnt) {
+		ThreadedResult r = runThreaded<Structure>(create, keys, ops);
+		if (!single) single = r.opsPerSec;
+		string cols[] = { std::to_string(ops.size()), std::to_string((long long)r.opsPerSec),
+			std::to_string(single > 0 ? r.opsPerSec / single : 0).substr(0, 4),
+			std::to_string(r.latency.valueAtPercentile(50)), std::to_string(r.latency.valueAtPercentile(99)),
+			std::to_string(r.worstThreadP99) };
+		std::cout << cols[0] << std::string(10 - cols[0].size(), ' ') << "|" <<
+			std::string(16 - cols[1].size(), ' ') << cols[1] << "|" <<
+			std::string(8 - cols[2].size(), ' ') << cols[2] << "x|" <<
+			std::string(9 - cols[3].size(), ' ') << cols[3] << "ns|" <<
+			std::string(9 - cols[4].size(), ' ') << cols[4] << "ns|" <<
+			std::string(16 - cols[5].size(), ' ') << cols[5] << "ns|\n";
+	}
+	std::cout << "---------------------------------------------------------------------------\n";
+}
+
+/// @brief Runs one mixed workload on 1, 2, 4 ... maxThreads threads for every structure and locking and prints the scaling
+void runThreadsMode(const WorkloadConfig& config, unsigned maxThreads) {
+	if (maxThreads < 1 || maxThreads >= (unsigned)CSL_MAX_THREADS) {
+		throw std::invalid_argument("Threads must be from 1 to " + std::to_string(CSL_MAX_THREADS - 1));
+	}
+	const std::vector<int> keys = WorkloadGenerator(config).loadKeys();
+	//the operations of all threads together are the same count for every number of threads
+	std::vector<std::vector<std::vector<WorkloadOp>>> opsByThreadCnt;
+	for (unsigned threadCnt = 1; ; threadCnt = std::min(threadCnt * 2, maxThreads)) {
+		std::vector<std::vector<WorkloadOp>> ops;
+		for (unsigned t = 0; t < threadCnt; t++) {
+			ops.push_back(WorkloadGenerator(config, t, threadCnt).operations());
+		}
+		opsByThreadCnt.push_back(std::move(ops));
+		if (threadCnt == maxThreads) break;
+	}
+	const double total = config.readRatio + config.insertRatio + config.deleteRatio + config.scanRatio;
+	const int lvl = getOptimalLvlNum((int)(config.keyCount + config.opCount * config.insertRatio / total) + 1);
+	std::cout << "Workload: " << config.readRatio * 100 / total << "% read, " << config.insertRatio * 100 / total << "% insert, " <<
+		config.deleteRatio * 100 / total << "% delete, " << config.scanRatio * 100 / total << "% scan, " <<
+		config.distributionName() << " keys, " << config.keyCount << " loaded, " << config.opCount << " operations split between the threads\n";
+	std::cout << "Processors: " << processorCount() << ", thread i is pinned to processor i\n";
+
+	printScaling<MutexLockedSet<AVLTree<int>>>("AVL, one mutex", []() { return alignedNew<MutexLockedSet<AVLTree<int>>>(); }, keys, opsByThreadCnt);
+	printScaling<SharedLockedSet<AVLTree<int>>>("AVL, reader-writer lock", []() { return alignedNew<SharedLockedSet<AVLTree<int>>>(); }, keys, opsByThreadCnt);
+	printScaling<ShardedSet<AVLTree<int>>>("AVL, 16 shards with reader-writer locks", []() { return alignedNew<ShardedSet<AVLTree<int>>>(); }, keys, opsByThreadCnt);
+	printScaling<MutexLockedSet<SkipList<int>>>("SkipList, one mutex", [lvl]() { return alignedNew<MutexLockedSet<SkipList<int>>>(lvl, 0.5); }, keys, opsByThreadCnt);
+	printScaling<SharedLockedSet<SkipList<int>>>("SkipList, reader-writer lock", [lvl]() { return alignedNew<SharedLockedSet<SkipList<int>>>(lvl, 0.5); }, keys, opsByThreadCnt);
+	printScaling<ShardedSet<SkipList<int>>>("SkipList, 16 shards with reader-writer locks", [lvl]() { return alignedNew<ShardedSet<SkipList<int>>>(lvl, 0.5); }, keys, opsByThreadCnt);
+	printScaling<ConcurrentSkipList<int>>("ConcurrentSkipList, lock-free", [lvl]() { return alignedNew<ConcurrentSkipList<int>>(lvl, 0.5); }, keys, opsByThreadCnt);
+}
+
+/// @brief Adds the results of a phases test to a report
+void addResults(BenchReport& report, const string& phase, const TestHelperContainer& data) {
+	const string ops[] = { "insert", "delete", "search" };
+	for (int op = 0; op < 3; op++) {
+		for (const StructureStats& s : data.structures) {
+			const OpStats& stats = op == 0 ? s.insertion : op == 1 ? s.deletion : s.search;
+			BenchResult r;
+			r.phase = phase;
+			r.op = ops[op];
+			r.structure = s.name;
+			r.samples = stats.samples;
+			r.summarize();
+			r.p50 = stats.latency.valueAtPercentile(50);
+			r.p99 = stats.latency.valueAtPercentile(99);
+			r.memory = s.memory;
+			report.results.push_back(r);
+		}
+	}
+}
+
+/// @brief Prints every result of the current report next to the same one of the baseline. Returns the number of regressions
+int printComparison(const BenchReport& baseline, const BenchReport& current, double thresholdPercent) {
+	const char* checked[] = { "cpu", "compiler", "flags", "elements", "tests" };
+	for (const char* name : checked) {
+		auto before = baseline.info.find(name), now = current.info.find(name);
+		string b = before == baseline.info.end() ? "?" : before->second, n = now == current.info.end() ? "?" : now->second;
+		if (b != n) std::cout << "Note: " << name << " was " << b << ", now " << n << "\n";
+	}
+	std::cout << "\nComparison with the baseline (mean +- 95% confidence, regression: significant by Welch's t-test and slower by more than "
+		<< thresholdPercent << "%).\n";
+	std::cout << "--------------------------------------------------------------------------------------------\n";
+	std::cout << "result                  |     baseline ns    |     current ns     |   change |\n";
+	int regressions = 0;
+	auto interval = [](const BenchResult& r) {
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.1f +- %.1f", r.mean, confidence95(r));
+		return string(buf);
+	};
+	for (const BenchResult& now : current.results) {
+		string key = now.key();
+		const BenchResult* before = baseline.find(key);
+		std::cout << key << std::string(key.size() < 24 ? 24 - key.size() : 0, ' ') << "|";
+		if (!before) {
+			std::cout << "     not in baseline|\n";
+			continue;
+		}
+		BenchComparison c = compareResults(*before, now, thresholdPercent);
+		char change[16];
+		std::snprintf(change, sizeof(change), "%+.1f%%", c.changePercent);
+		string b = interval(*before), n = interval(now), ch = change;
+		std::cout << std::string(b.size() < 20 ? 20 - b.size() : 0, ' ') << b << "|" <<
+			std::string(n.size() < 20 ? 20 - n.size() : 0, ' ') << n << "|" <<
+			std::string(ch.size() < 10 ? 10 - ch.size() : 0, ' ') << ch << "| " <<
+			(c.regression ? "REGRESSION" : !c.significant ? "same" : c.changePercent < 0 ? "faster" : "slower (under threshold)") << "\n";
+		regressions += c.regression;
+	}
+	std::cout << "--------------------------------------------------------------------------------------------\n";
+	std::cout << regressions << " regression(s)\n";
+	return regressions;
+}
+
+const char* USAGE =
+"Options (--name value or --name=value, --config file with name = value lines):\n"
+"  --mode phases|workload|threads   phases: the insert/search/delete tests (default), workload: one mixed run,\n"
+"                           threads: the mixed run on 1, 2, 4 ... threads with each locking\n"
+"  --threads N              most threads for the threads mode (default: number of processors)\n"
+"  --elements N --tests N   size and repetitions of the phases tests\n"
+"  --structures LIST        comma separated structures for the phases and workload modes, some of\n"
+"                           avl,skiplist,unrolled,btree,set,uset,vector (default all; vector only up to\n"
+"                           100000 elements, as every insert and remove moves half of it)\n"
+"  --counters 0|1           count hardware events per operation in the phases tests (Linux perf_event_open)\n"
+"  --json FILE --csv FILE   save the phases results with the environment (compiler, flags, cpu, seed ...)\n"
+"  --compare FILE           compare the phases results with a saved baseline, exit code 2 on regressions\n"
+"  --current FILE           with --compare: compare this saved result instead of running the tests\n"
+"  --threshold P            smallest slowdown in percent that is a regression (default 2)\n"
+"  --read R --insert R --delete R --scan R   parts of the workload operations (default 0.95 read, 0.05 insert)\n"
+"  --dist uniform|zipfian|sequential|latest|hotspot   key distribution (default zipfian)\n"
+"  --keys N --ops N --scanlen N   loaded keys, operations, values per scan\n"
+"  --theta T --hotset F --hotops F --ordered 0|1\n"
+"  --seed S                 seed of the workloads and of the phases tests (default for the phases: the time)\n";
+
+int main(int argc, char** argv) {
+	try {
+		string mode = "phases";
+		int testNum = 30;
+		int elemCnt = 1'000;
+		unsigned maxThreads = processorCount();
+		bool useCounters = false;
+		string jsonPath, csvPath, comparePath, currentPath;
+		string structures;
+		double threshold = 2;
+		WorkloadConfig workload;
+		const std::map<string, string> options = readOptions(argc, argv);
+		for (const auto& option : options) {
+			if (option.first == "mode") mode = option.second;
+			else if (option.first == "tests") testNum = (int)optionNumber(option.first, option.second);
+			else if (option.first == "elements") elemCnt = (int)optionNumber(option.first, option.second);
+			else if (option.first == "counters") useCounters = optionNumber(option.first, option.second) != 0;
+			else if (option.first == "threads") maxThreads = (unsigned)optionNumber(option.first, option.second);
+			else if (option.first == "structures") structures = option.second;
+			else if (option.first == "json") jsonPath = option.second;
+			else if (option.first == "csv") csvPath = option.second;
+			else if (option.first == "compare") comparePath = option.second;
+			else if (option.first == "current") currentPath = option.second;
+			else if (option.first == "threshold") threshold = optionNumber(option.first, option.second);
+			else if (!workload.set(option.first, option.second)) {
+				throw std::invalid_argument("Unknown option --" + option.first);
+			}
+		}
+		if (!currentPath.empty()) {
+			if (comparePath.empty()) throw std::invalid_argument("--current needs --compare");
+			return printComparison(BenchReport::load(comparePath), BenchReport::load(currentPath), threshold) ? 2 : 0;
+		}
+		if (mode == "workload") {
+			runWorkloadMode(workload, structures.empty() ? STRUCTURE_NAMES : structures);
+			return 0;
+		}
+		if (mode == "threads") {
+			runThreadsMode(workload, maxThreads);
+			return 0;
+		}
+		if (mode != "phases") throw std::invalid_argument("Unknown mode " + mode);
+		if (testNum < 1 || elemCnt < 100) throw std::invalid_argument("Phases need at least 1 test and 100 elements");
+		if (structures.empty()) structures = elemCnt <= 100'000 ? STRUCTURE_NAMES : "avl,skiplist,unrolled,btree,set,uset";
+		Contenders contenders = makeContenders(structures, elemCnt);
+		//the baseline is read before the long run, so a wrong file is found early
+		BenchReport baseline;
+		if (!comparePath.empty()) baseline = BenchReport::load(comparePath);
+		const unsigned seed = options.count("seed") ? (unsigned)workload.seed : (unsigned)time(NULL);
+		srand(seed);
 		std::cout << "Running " << testNum << " tests with " << elemCnt << " elements each and\n";
 		std::cout << "taking their average results per operation...\n";
-		auto data = findAvgInsertDelFind(elemCnt, testNum);
+		std::cout << "Clock: " << (TestHelperContainer::clock().usesTsc() ? "rdtsc" : "steady_clock")
+			<< ", own cost " << TestHelperContainer::clock().getOverheadNs() << "ns (subtracted)\n";
+		std::unique_ptr<PerfCounters> counters;
+		if (useCounters) {
+			counters.reset(new PerfCounters());
+			if (!counters->available()) {
+				std::cout << "Hardware counters are not available (" << counters->getError() << "), running without them\n";
+				counters.reset();
+			}
+			else if (!counters->getError().empty()) {
+				std::cout << "Some hardware counters are not available (" << counters->getError() << ")\n";
+			}
+		}
+		BenchReport report;
+		report.info = benchEnvironment();
+		report.info["mode"] = "phases";
+		report.info["elements"] = std::to_string(elemCnt);
+		report.info["tests"] = std::to_string(testNum);
+		report.info["seed"] = std::to_string(seed);
+		report.info["clock"] = TestHelperContainer::clock().usesTsc() ? "rdtsc" : "steady_clock";
+		report.info["structures"] = structures;
+		auto data = findAvgInsertDelFind(contenders, elemCnt, testNum, seed, counters.get());
+		addResults(report, "single", data);
 		
 		std::cout << "\nResult:\n\n";
 		std::cout << "\nAverage time that each operation needs to complete with one element.\n";
-		printPrettyTable(data.avg);
-		std::cout << "\n\nSlowest time for one operation.\n";
-		//__________
-		printPrettyTable(data.slowest, "__Slowest_");
+		printPrettyTable(data);
+		std::cout << "\n\nLatency percentiles for one operation.\n";
+		printLatencyTable(data);
+		if (counters) {
+			std::cout << "\n\nHardware events per operation.\n";
+			printEventsTable(data);
+		}
 		//
 		std::cout << "\n\nAvg time when used constantly with many elements.\n";
 		//__________
-		data = findAvgWhenWorkingWithManyElements(elemCnt, testNum);
-		printPrettyTable(data.avg);
+		data = findAvgWhenWorkingWithManyElements(contenders, elemCnt, testNum, seed, counters.get());
+		addResults(report, "many", data);
+		printPrettyTable(data);
+		std::cout << "\n\nLatency percentiles when used constantly with many elements.\n";
+		printLatencyTable(data);
+		if (counters) {
+			std::cout << "\n\nHardware events per operation when used constantly with many elements.\n";
+			printEventsTable(data);
+		}
+		if (!jsonPath.empty()) report.save(jsonPath, false);
+		if (!csvPath.empty()) report.save(csvPath, true);
+		if (!comparePath.empty() && printComparison(baseline, report, threshold)) return 2;
 	}
 	catch (const std::bad_alloc&) {
 		std::cout << "\nError :Not enough memory to perform the tests.\n";
+		return 1;
+	}
+	catch (const std::invalid_argument& e) {
+		std::cout << "\nError :" << e.what() << "\n" << USAGE;
+		return 1;
 	}
 	catch (const std::exception& e) {
+		//a baseline or result that can not be loaded or saved must not count as a pass
 		std::cout << "\nError :" << e.what() << "\n";
+		return 1;
 	}
 
 
@@ -363,6 +888,8 @@ You dont need to lock and synchronized the whole structure.
 However, when using AVL you should expect to go down and up the tree and lock many nodes
 when balancing (rotating) and that makes dead lock and synchronization
 problems more likely to occur.
+ConcurrentSkipList (T_ConcurrentSkipList.h) shows that: it needs no locks at all, only CAS on the
+pointers next to the changed node.
  
 
  Note: Slowest time for operation depends on too many factors as processor business 
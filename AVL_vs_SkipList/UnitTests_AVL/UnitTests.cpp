@@ -3,6 +3,9 @@
 #include <time.h> 
 #include <unordered_set>
 #include <cmath>
+#include <set>
+#include <iterator>
+#include <vector>
 //
 #include "catch.hpp"
 #include "../Template_AVL_SkipList/T_AVLTree.h" 
@@ -31,6 +34,8 @@ SCENARIO("Testing AVLTree<int> class insertion") {
 			REQUIRE(tree.insert(3));
 			REQUIRE(!tree.insert(3));
 			REQUIRE(!tree.insert(3));
+			REQUIRE(tree.getSize() == 1);
+			REQUIRE(tree.exists(3));
 		}
 		WHEN("Insert 1000 random elements") {
 			std::unordered_set<int> set;
@@ -58,6 +63,10 @@ SCENARIO("Testing AVLTree<int> class insertion") {
 			THEN("Test for correct height") {
 				REQUIRE(tree.getHeight() <= 1.5 * log2(TEST_NUM));
 			}
+			THEN("Test for compact nodes") {
+				//value, balance and count bits and two child pointers
+				REQUIRE(tree.getBytesUsed() <= sizeof(AVLTree<int>) + TEST_NUM * (2 * sizeof(int) + 2 * sizeof(void*)));
+			}
 		}//when
 	}//given
 }//scen
@@ -116,6 +125,16 @@ SCENARIO("Testing AVLTree<int> class deletion") {
 				}
 				REQUIRE(tree.getSize() == 0);
 			}
+			THEN("Test removing half of them keeps the tree balanced") {
+				for (int i = 0; i < TEST_NUM / 2; i++) {
+					REQUIRE(tree.remove(values[i]));
+				}
+				for (int i = TEST_NUM / 2; i < TEST_NUM; i++) {
+					REQUIRE(tree.exists(values[i]));
+				}
+				REQUIRE(tree.getSize() == TEST_NUM / 2);
+				REQUIRE(tree.getHeight() <= 1.5 * log2(TEST_NUM / 2));
+			}
 
 		}//when
 	}//given
@@ -221,6 +240,288 @@ SCENARIO("Testing AVLTree<int> class iteration left-parent-right") {
 				REQUIRE(test_arr[i]);
 			}
 		}
+		WHEN("Insert elements in random order and remove some") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				tree.insert(rand() % (TEST_NUM * 4));
+			}
+			for (int i = 0; i < TEST_NUM; i++) {
+				tree.remove(rand() % (TEST_NUM * 4));
+			}
+			THEN("Check if iteration gives the values in ascending order") {
+				size_t cnt = 0;
+				int prev = -1;
+				for (auto node : tree) {
+					REQUIRE(prev < node->value);
+					prev = node->value;
+					cnt++;
+				}
+				REQUIRE(cnt == tree.getSize());
+			}
+		}
+	}//given
+	GIVEN("An empty tree") {
+		AVLTree<int> tree;
+		THEN("Check if begin is the end") {
+			REQUIRE(tree.begin() == tree.end());
+			auto it = tree.begin();
+			REQUIRE(*(++it) == nullptr);
+		}
+	}//given
+}//scen
+
+
+SCENARIO("Testing AVLTree<int> class with different node allocators") {
+	GIVEN("Trees with heap and slab allocators") {
+		AVLTree<int, HeapAllocator> heapTree;
+		AVLTree<int, SlabAllocator<4096>> slabTree;
+		const int TEST_NUM = 1000;
+		WHEN("Insert and remove the same elements in both") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(heapTree.insert(i));
+				REQUIRE(slabTree.insert(i));
+			}
+			for (int i = 0; i < TEST_NUM; i += 2) {
+				REQUIRE(heapTree.remove(i));
+				REQUIRE(slabTree.remove(i));
+			}
+			THEN("Test if both have the same elements") {
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(heapTree.exists(i) == (i % 2 == 1));
+					REQUIRE(slabTree.exists(i) == (i % 2 == 1));
+				}
+				REQUIRE(heapTree.getSize() == TEST_NUM / 2);
+				REQUIRE(slabTree.getSize() == TEST_NUM / 2);
+			}
+			THEN("Test clearing and reusing them") {
+				heapTree.clearData();
+				slabTree.clearData();
+				REQUIRE(heapTree.getBytesUsed() == sizeof(heapTree));
+				REQUIRE(slabTree.getBytesUsed() == sizeof(slabTree));
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(!slabTree.exists(i));
+					REQUIRE(slabTree.insert(i));
+				}
+				REQUIRE(slabTree.getSize() == TEST_NUM);
+			}
+		}//when
+	}//given
+}//scen
+
+SCENARIO("Testing AVLTree<int> class order statistics") {
+	GIVEN("A tree and a std::set with the same random elements") {
+		AVLTree<int> tree;
+		std::set<int> check;
+		const int TEST_NUM = 3000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = rand() % (TEST_NUM * 4);
+			tree.insert(val);
+			check.insert(val);
+		}
+		WHEN("Remove some of them") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				int val = rand() % (TEST_NUM * 4);
+				tree.remove(val);
+				check.erase(val);
+			}
+			THEN("Test select() for every position") {
+				size_t k = 0;
+				for (int val : check) {
+					REQUIRE(tree.select(k) != nullptr);
+					REQUIRE(*tree.select(k) == val);
+					k++;
+				}
+				REQUIRE(tree.select(check.size()) == nullptr);
+			}
+			THEN("Test rank() and countInRange()") {
+				for (int val = -1; val <= TEST_NUM * 4; val += 7) {
+					REQUIRE(tree.rank(val) == (size_t)std::distance(check.begin(), check.lower_bound(val)));
+					size_t cnt = std::distance(check.lower_bound(val), check.lower_bound(val + 100));
+					REQUIRE(tree.countInRange(val, val + 100) == cnt);
+				}
+				REQUIRE(tree.countInRange(10, 10) == 0);
+				REQUIRE(tree.countInRange(10, 5) == 0);
+			}
+		}
+	}//given
+	GIVEN("A copy of a tree") {
+		AVLTree<int> tree;
+		for (int i = 0; i < 100; i++) {
+			tree.insert(i * 2);
+		}
+		AVLTree<int> copy(tree);
+		THEN("Test if the counts are copied") {
+			REQUIRE(copy.rank(50) == 25);
+			REQUIRE(*copy.select(99) == 198);
+		}
 	}//given
 }//scen
 
+SCENARIO("Testing AVLTree<int> class range scans") {
+	GIVEN("A tree with the even numbers from 0 to 2 * TEST_NUM") {
+		AVLTree<int> tree;
+		const int TEST_NUM = 2000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			REQUIRE(tree.insert(i * 2));
+		}
+		THEN("Test lowerBound() and upperBound()") {
+			REQUIRE(*tree.lowerBound(-5) == 0);
+			REQUIRE(*tree.lowerBound(10) == 10);
+			REQUIRE(*tree.lowerBound(11) == 12);
+			REQUIRE(*tree.upperBound(10) == 12);
+			REQUIRE(*tree.upperBound(11) == 12);
+			REQUIRE(tree.lowerBound(TEST_NUM * 2) == nullptr);
+			REQUIRE(tree.upperBound(TEST_NUM * 2 - 2) == nullptr);
+		}
+		THEN("Test forEachInRange() for different ranges") {
+			for (int lo = -3; lo < TEST_NUM * 2 + 3; lo += 37) {
+				int hi = lo + rand() % 200;
+				std::vector<int> got;
+				tree.forEachInRange(lo, hi, [&got](int val) { got.push_back(val); });
+				std::vector<int> expected;
+				for (int val = lo < 0 ? 0 : lo + (lo % 2); val < hi && val < TEST_NUM * 2; val += 2) {
+					expected.push_back(val);
+				}
+				REQUIRE(got == expected);
+			}
+			int cnt = 0;
+			tree.forEachInRange(100, 100, [&cnt](int) { cnt++; });
+			tree.forEachInRange(100, 50, [&cnt](int) { cnt++; });
+			REQUIRE(cnt == 0);
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing AVLTree<int> class bulk load from sorted values") {
+	GIVEN("A tree with some elements and sorted vectors") {
+		AVLTree<int> tree;
+		tree.insert(-10);
+		std::vector<int> sorted;
+		const int TEST_NUM = 5000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			sorted.push_back(i * 3);
+		}
+		WHEN("Build from the sorted vector") {
+			REQUIRE(tree.buildFromSorted(sorted.begin(), sorted.end()));
+			THEN("Test if the tree has only the new values in order and is balanced") {
+				REQUIRE(tree.getSize() == TEST_NUM);
+				REQUIRE_FALSE(tree.exists(-10));
+				REQUIRE(tree.getHeight() == (size_t)std::ceil(std::log2(TEST_NUM + 1)));
+				int expected = 0;
+				for (auto node : tree) {
+					REQUIRE(node->value == expected);
+					expected += 3;
+				}
+				REQUIRE(*tree.select(100) == 300);
+				REQUIRE(tree.rank(301) == 101);
+			}
+			THEN("Test if insertion and deletion keep working") {
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(tree.insert(i * 3 + 1));
+				}
+				for (int i = 0; i < TEST_NUM; i += 2) {
+					REQUIRE(tree.remove(i * 3));
+				}
+				REQUIRE(tree.getSize() == TEST_NUM + TEST_NUM / 2);
+				REQUIRE(tree.getHeight() <= 1.45 * std::log2(tree.getSize() + 2));
+				REQUIRE(*tree.select(0) == 1);
+			}
+		}
+		WHEN("Build from wrong or empty ranges") {
+			std::vector<int> unsorted = { 1, 5, 3 };
+			std::vector<int> repeated = { 1, 2, 2, 3 };
+			THEN("Test if wrong ranges do not change the tree") {
+				REQUIRE_FALSE(tree.buildFromSorted(unsorted.begin(), unsorted.end()));
+				REQUIRE_FALSE(tree.buildFromSorted(repeated.begin(), repeated.end()));
+				REQUIRE(tree.getSize() == 1);
+				REQUIRE(tree.exists(-10));
+			}
+			THEN("Test if an empty range clears the tree") {
+				REQUIRE(tree.buildFromSorted(sorted.begin(), sorted.begin()));
+				REQUIRE(tree.getSize() == 0);
+				REQUIRE(tree.begin() == tree.end());
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing AVLTree<int> class structure-preserving copies") {
+	GIVEN("Big trees with different allocators") {
+		AVLTree<int> tree;
+		AVLTree<int, HeapAllocator> heapTree;
+		const int TEST_NUM = 100000;//big enough to be copied by many threads
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = (rand() % 32768) * 32768 + rand() % 32768;
+			tree.insert(val);
+			heapTree.insert(val);
+		}
+		WHEN("Copy them") {
+			AVLTree<int> copy(tree);
+			AVLTree<int, HeapAllocator> heapCopy(heapTree);
+			THEN("Test if the copies have the same structure") {
+				REQUIRE(copy.getSize() == tree.getSize());
+				REQUIRE(copy.getHeight() == tree.getHeight());
+				REQUIRE(heapCopy.getBytesUsed() == heapTree.getBytesUsed());
+				auto it = tree.begin();
+				for (auto node : copy) {
+					REQUIRE(node->value == (*it)->value);
+					REQUIRE(node->balance == (*it)->balance);
+					REQUIRE(node->count == (*it)->count);
+					++it;
+				}
+				REQUIRE(it == tree.end());
+			}
+			THEN("Test if the copies work on their own") {
+				auto values = std::vector<int>();
+				for (auto node : tree) values.push_back(node->value);
+				for (size_t i = 0; i < values.size(); i += 2) {
+					REQUIRE(copy.remove(values[i]));
+					REQUIRE(heapCopy.remove(values[i]));
+				}
+				REQUIRE(tree.getSize() == values.size());
+				REQUIRE(copy.getSize() == values.size() / 2);
+				REQUIRE(*copy.select(0) == values[1]);
+				REQUIRE(copy.getHeight() <= 1.45 * std::log2(copy.getSize() + 2));
+				copy = tree;
+				REQUIRE(copy.getSize() == tree.getSize());
+				REQUIRE(copy.exists(values[0]));
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing AVLTree<int> class batched lookups") {
+	GIVEN("A tree with random elements") {
+		AVLTree<int> tree;
+		const int TEST_NUM = 20000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			tree.insert(rand() % (TEST_NUM * 2));
+		}
+		WHEN("Check batches of different sizes with existsMany()") {
+			std::vector<int> keys;
+			for (int i = 0; i < 1000; i++) {
+				keys.push_back(rand() % (TEST_NUM * 2 + 10) - 5);
+			}
+			THEN("Test if the results are the same as with exists()") {
+				for (size_t batch : { size_t(0), size_t(1), size_t(7), size_t(64), size_t(1000) }) {
+					std::vector<char> out(batch + 1, 2);
+					tree.existsMany(keys.data(), batch, reinterpret_cast<bool*>(out.data()));
+					for (size_t i = 0; i < batch; i++) {
+						REQUIRE((bool)out[i] == tree.exists(keys[i]));
+					}
+					REQUIRE(out[batch] == 2);
+				}
+			}
+		}
+		WHEN("Check in an empty tree") {
+			tree.clearData();
+			int keys[] = { 1, 2, 3 };
+			bool out[] = { true, true, true };
+			tree.existsMany(keys, 3, out);
+			THEN("Test if nothing is found") {
+				REQUIRE_FALSE(out[0]);
+				REQUIRE_FALSE(out[1]);
+				REQUIRE_FALSE(out[2]);
+			}
+		}
+	}//given
+}//scen
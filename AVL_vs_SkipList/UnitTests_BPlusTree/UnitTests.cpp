@@ -0,0 +1,359 @@
+#define CATCH_CONFIG_MAIN
+#include <stdlib.h>     /* srand, rand */
+#include <time.h>
+#include <unordered_set>
+#include <cmath>
+#include <set>
+#include <iterator>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+//
+#include "../UnitTests_AVL/catch.hpp"
+#include "../Template_AVL_SkipList/T_BPlusTree.h"
+
+
+
+SCENARIO("Testing BPlusTree<int> class insertion") {
+	srand(time(NULL));
+	GIVEN("Creating default object") {
+		BPlusTree<int> tree;
+		WHEN("Insert 3 elements") {
+			REQUIRE(tree.insert(1));
+			REQUIRE(tree.insert(3));
+			REQUIRE(tree.insert(2));
+			THEN("Test finding the elements") {
+				REQUIRE(tree.exists(1));
+				REQUIRE(tree.exists(2));
+				REQUIRE(tree.exists(3));
+				REQUIRE(tree.exists(4) == false);
+			}
+			THEN("Test for getSize and repetitions") {
+				REQUIRE(tree.getSize() == 3);
+				REQUIRE_FALSE(tree.insert(2));
+				REQUIRE(tree.getSize() == 3);
+				REQUIRE(tree.getHeight() == 1);
+			}
+		}
+		WHEN("Insert many elements in ascending, descending and random order") {
+			const int TEST_NUM = 20000;
+			std::set<int> set;
+			for (int i = 0; i < TEST_NUM; i++) {
+				int val = i % 3 == 0 ? i : i % 3 == 1 ? -i : rand() % (TEST_NUM * 10);
+				REQUIRE(tree.insert(val) == set.insert(val).second);
+			}
+			THEN("Test if all of them are found and the tree is low") {
+				REQUIRE(tree.getSize() == set.size());
+				for (int val : set) {
+					REQUIRE(tree.exists(val));
+				}
+				REQUIRE_FALSE(tree.exists(TEST_NUM * 10 + 1));
+				//every node below the root is at least half full
+				REQUIRE(tree.getHeight() <= 2 + std::log(set.size()) / std::log(10));
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing BPlusTree<int> class deletion") {
+	GIVEN("Creating default object") {
+		BPlusTree<int> tree;
+		WHEN("Insert 3 elements") {
+			tree.insert(1);
+			tree.insert(3);
+			tree.insert(2);
+			THEN("Try removing them") {
+				REQUIRE(tree.remove(2));
+				REQUIRE(!tree.exists(2));
+				REQUIRE_FALSE(tree.remove(2));
+				REQUIRE(tree.remove(1));
+				REQUIRE(tree.remove(3));
+				REQUIRE(tree.getSize() == 0);
+				REQUIRE(tree.getHeight() == 0);
+				REQUIRE(tree.begin() == tree.end());
+			}
+		}//when
+		WHEN("Insert and remove random elements many times") {
+			const int TEST_NUM = 30000;
+			std::set<int> set;
+			for (int i = 0; i < TEST_NUM; i++) {
+				int val = rand() % (TEST_NUM / 2);
+				if (rand() % 3) REQUIRE(tree.insert(val) == set.insert(val).second);
+				else REQUIRE(tree.remove(val) == (set.erase(val) == 1));
+			}
+			THEN("Test if the tree has the same values as a std::set") {
+				REQUIRE(tree.getSize() == set.size());
+				auto it = set.begin();
+				for (auto value : tree) {
+					REQUIRE(*value == *it);
+					++it;
+				}
+				REQUIRE(it == set.end());
+			}
+			THEN("Test removing all of them shrinks the tree back") {
+				std::vector<int> values(set.begin(), set.end());
+				for (size_t i = 0; i < values.size(); i++) {
+					std::swap(values[i], values[i + rand() % (values.size() - i)]);
+				}
+				for (size_t i = 0; i < values.size(); i++) {
+					REQUIRE(tree.remove(values[i]));
+					if (i % 1000 == 0) REQUIRE(tree.getSize() == values.size() - i - 1);
+				}
+				REQUIRE(tree.getSize() == 0);
+				REQUIRE(tree.getHeight() == 0);
+				REQUIRE(tree.getBytesUsed() == sizeof(tree));
+			}
+		}//when
+	}//given
+}//scen
+
+SCENARIO("Test BPlusTree<int> class operators and constructors")
+{
+	GIVEN("A tree with many elements") {
+		BPlusTree<int> tree;
+		const int TEST_NUM = 5000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			tree.insert(i * 7 % TEST_NUM);
+		}
+		WHEN("Copy it with the copy constr and copy operator=") {
+			BPlusTree<int> copy(tree);
+			BPlusTree<int> assigned;
+			assigned.insert(-1);
+			assigned = tree;
+			THEN("Test if the copies have the same values and are not bound to the original") {
+				REQUIRE(copy.getSize() == TEST_NUM);
+				REQUIRE(assigned.getSize() == TEST_NUM);
+				REQUIRE_FALSE(assigned.exists(-1));
+				REQUIRE(copy.getHeight() == tree.getHeight());
+				int expected = 0;
+				for (auto value : copy) {
+					REQUIRE(*value == expected++);
+				}
+				for (int i = 0; i < TEST_NUM; i += 2) {
+					REQUIRE(tree.remove(i));
+				}
+				REQUIRE(copy.exists(0));
+				REQUIRE(assigned.exists(0));
+				REQUIRE(copy.getBytesUsed() == assigned.getBytesUsed());
+			}
+		}
+		WHEN("Move it with the move constr and move operator=") {
+			BPlusTree<int> moved(std::move(tree));
+			BPlusTree<int> assigned;
+			assigned.insert(-1);
+			assigned = std::move(moved);
+			THEN("Test if the values went to the last tree") {
+				REQUIRE(tree.getSize() == 0);
+				REQUIRE(moved.getSize() == 0);
+				REQUIRE(assigned.getSize() == TEST_NUM);
+				REQUIRE_FALSE(assigned.exists(-1));
+				REQUIRE(assigned.exists(TEST_NUM - 1));
+				REQUIRE(tree.insert(3));
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing BPlusTree<int> class range scans") {
+	GIVEN("A tree with the even numbers from 0 to 2 * TEST_NUM") {
+		BPlusTree<int> tree;
+		const int TEST_NUM = 2000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			REQUIRE(tree.insert(i * 2));
+		}
+		THEN("Test lowerBound() and upperBound()") {
+			REQUIRE(*tree.lowerBound(-5) == 0);
+			REQUIRE(*tree.lowerBound(10) == 10);
+			REQUIRE(*tree.lowerBound(11) == 12);
+			REQUIRE(*tree.upperBound(10) == 12);
+			REQUIRE(*tree.upperBound(11) == 12);
+			REQUIRE(tree.lowerBound(TEST_NUM * 2) == nullptr);
+			REQUIRE(tree.upperBound(TEST_NUM * 2 - 2) == nullptr);
+			//every value as a bound, so the bounds cross the leaves
+			for (int i = 0; i < TEST_NUM * 2 - 2; i++) {
+				REQUIRE(*tree.upperBound(i) == i + 2 - i % 2);
+				REQUIRE(*tree.lowerBound(i + 1) == i + 2 - i % 2);
+			}
+		}
+		THEN("Test forEachInRange() for different ranges") {
+			for (int lo = -3; lo < TEST_NUM * 2 + 3; lo += 37) {
+				int hi = lo + rand() % 400;
+				std::vector<int> got;
+				tree.forEachInRange(lo, hi, [&got](int val) { got.push_back(val); });
+				std::vector<int> expected;
+				for (int val = lo < 0 ? 0 : lo + (lo % 2); val < hi && val < TEST_NUM * 2; val += 2) {
+					expected.push_back(val);
+				}
+				REQUIRE(got == expected);
+			}
+			int cnt = 0;
+			tree.forEachInRange(100, 100, [&cnt](int) { cnt++; });
+			tree.forEachInRange(100, 50, [&cnt](int) { cnt++; });
+			REQUIRE(cnt == 0);
+		}
+	}//given
+	GIVEN("An empty tree") {
+		BPlusTree<int> tree;
+		THEN("Test if there are no bounds and begin is the end") {
+			REQUIRE(tree.lowerBound(0) == nullptr);
+			REQUIRE(tree.upperBound(0) == nullptr);
+			REQUIRE(tree.begin() == tree.end());
+			auto it = tree.begin();
+			REQUIRE(*(++it) == nullptr);
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing BPlusTree<int> class bulk load from sorted values") {
+	GIVEN("A tree with some elements and sorted vectors") {
+		BPlusTree<int> tree;
+		tree.insert(-10);
+		std::vector<int> sorted;
+		const int TEST_NUM = 50000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			sorted.push_back(i * 3);
+		}
+		WHEN("Build from the sorted vector") {
+			REQUIRE(tree.buildFromSorted(sorted.begin(), sorted.end()));
+			THEN("Test if the tree has only the new values in order") {
+				REQUIRE(tree.getSize() == TEST_NUM);
+				REQUIRE_FALSE(tree.exists(-10));
+				int expected = 0;
+				for (auto value : tree) {
+					REQUIRE(*value == expected);
+					expected += 3;
+				}
+				REQUIRE(expected == TEST_NUM * 3);
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(tree.exists(i * 3));
+					REQUIRE_FALSE(tree.exists(i * 3 + 1));
+				}
+			}
+			THEN("Test if insertion and deletion keep working") {
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(tree.insert(i * 3 + 1));
+				}
+				for (int i = 0; i < TEST_NUM; i += 2) {
+					REQUIRE(tree.remove(i * 3));
+				}
+				REQUIRE(tree.getSize() == TEST_NUM + TEST_NUM / 2);
+				REQUIRE(*tree.lowerBound(0) == 1);
+				REQUIRE(*tree.upperBound(1) == 3);
+			}
+		}
+		WHEN("Build from small ranges") {
+			for (int cnt = 1; cnt < 200; cnt++) {
+				REQUIRE(tree.buildFromSorted(sorted.begin(), sorted.begin() + cnt));
+				REQUIRE(tree.getSize() == (size_t)cnt);
+				int seen = 0;
+				for (auto value : tree) {
+					REQUIRE(*value == sorted[seen++]);
+				}
+				REQUIRE(seen == cnt);
+			}
+		}
+		WHEN("Build from wrong or empty ranges") {
+			std::vector<int> unsorted = { 1, 5, 3 };
+			std::vector<int> repeated = { 1, 2, 2, 3 };
+			THEN("Test if wrong ranges do not change the tree") {
+				REQUIRE_FALSE(tree.buildFromSorted(unsorted.begin(), unsorted.end()));
+				REQUIRE_FALSE(tree.buildFromSorted(repeated.begin(), repeated.end()));
+				REQUIRE(tree.getSize() == 1);
+				REQUIRE(tree.exists(-10));
+			}
+			THEN("Test if an empty range clears the tree") {
+				REQUIRE(tree.buildFromSorted(sorted.begin(), sorted.begin()));
+				REQUIRE(tree.getSize() == 0);
+				REQUIRE(tree.begin() == tree.end());
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing BPlusTree<int> class with different node allocators") {
+	GIVEN("Trees with heap and slab allocators") {
+		BPlusTree<int, HeapAllocator> heapTree;
+		BPlusTree<int, SlabAllocator<>> slabTree;
+		const int TEST_NUM = 10000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = rand() % (TEST_NUM * 4);
+			REQUIRE(heapTree.insert(val) == slabTree.insert(val));
+		}
+		THEN("Test if both have the same values and use memory only for the nodes") {
+			REQUIRE(heapTree.getSize() == slabTree.getSize());
+			auto it = slabTree.begin();
+			for (auto value : heapTree) {
+				REQUIRE(*value == **it);
+				++it;
+			}
+			//every value takes 4 bytes and the nodes are at least half full
+			REQUIRE(heapTree.getBytesUsed() < heapTree.getSize() * 4 * 2 * 1.3 + 1024);
+		}
+		THEN("Test if removing all values gives all memory back") {
+			for (int i = 0; i < TEST_NUM * 4; i++) {
+				heapTree.remove(i);
+			}
+			REQUIRE(heapTree.getSize() == 0);
+			REQUIRE(heapTree.getBytesUsed() == sizeof(heapTree));
+			slabTree.clearData();
+			REQUIRE(slabTree.getBytesUsed() == sizeof(slabTree));
+		}
+	}//given
+}//scen
+
+/// @brief Checks lowerIndex() and upperIndex() of BlockSearch<T> at every SimdLevel that the processor has
+/// against std::lower_bound/upper_bound, for blocks of all sizes up to 150 keys with the smallest and biggest values
+template <class T>
+void checkBlockSearch() {
+	std::vector<T> keys;
+	std::vector<T> probes = { std::numeric_limits<T>::min(), std::numeric_limits<T>::max(), 0, 1 };
+	for (int i = 0; i < 150; i++) {
+		T key = (T)((long long)rand() * rand() - (std::is_signed<T>::value ? RAND_MAX / 2 * (long long)RAND_MAX : 0));
+		if (i == 3) key = std::numeric_limits<T>::min();
+		if (i == 7) key = std::numeric_limits<T>::max();
+		keys.push_back(key);
+		probes.push_back(key);
+		if (key != std::numeric_limits<T>::max()) probes.push_back((T)(key + 1));
+		if (key != std::numeric_limits<T>::min()) probes.push_back((T)(key - 1));
+	}
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	for (int level = 0; level <= (int)simdLevel(); level++) {
+		for (size_t cnt = 0; cnt <= keys.size(); cnt++) {
+			for (T val : probes) {
+				size_t lower = std::lower_bound(keys.begin(), keys.begin() + cnt, val) - keys.begin();
+				size_t upper = std::upper_bound(keys.begin(), keys.begin() + cnt, val) - keys.begin();
+				REQUIRE(BlockSearch<T>::lowerIndex(keys.data(), cnt, val, (SimdLevel)level) == lower);
+				REQUIRE(BlockSearch<T>::upperIndex(keys.data(), cnt, val, (SimdLevel)level) == upper);
+			}
+		}
+	}
+}
+
+SCENARIO("Testing BlockSearch for integral keys") {
+	GIVEN("Sorted blocks with negative, positive and border values") {
+		THEN("Test 32-bit keys") {
+			checkBlockSearch<int32_t>();
+			checkBlockSearch<uint32_t>();
+		}
+		THEN("Test 64-bit keys") {
+			checkBlockSearch<int64_t>();
+			checkBlockSearch<uint64_t>();
+		}
+		THEN("Test a tree with 64-bit keys that go over the signed range") {
+			BPlusTree<uint64_t> tree;
+			std::set<uint64_t> checker;
+			for (int i = 0; i < 20000; i++) {
+				uint64_t val = (uint64_t)rand() * 0x9E3779B97F4A7C15ull;
+				REQUIRE(tree.insert(val) == checker.insert(val).second);
+			}
+			auto expected = checker.begin();
+			for (auto it = tree.begin(); it != tree.end(); ++it, ++expected) {
+				REQUIRE(**it == *expected);
+				REQUIRE(tree.exists(*expected));
+			}
+			REQUIRE(*tree.upperBound(0) == *checker.upper_bound(0));
+		}
+	}//given
+}//scen
@@ -3,9 +3,16 @@
 #include <time.h> 
 #include <unordered_set>
 #include <cmath>
+#include <set>
+#include <iterator>
 //
 #include "../UnitTests_AVL/catch.hpp"
 #include "../Template_AVL_SkipList/T_SkipList.h" 
+#include "../Template_AVL_SkipList/T_ConcurrentSkipList.h"
+#include "../Template_AVL_SkipList/T_UnrolledSkipList.h"
+#include <string>
+#include <thread>
+#include <vector>
 
 SCENARIO("Testing SkipList<int> class insertion") {
 	srand(time(NULL));
@@ -30,6 +37,17 @@ SCENARIO("Testing SkipList<int> class insertion") {
 			REQUIRE(!slist.insert(3));
 			REQUIRE(!slist.insert(3));
 		}
+		WHEN("Insert the default value after smaller ones") {
+			REQUIRE(slist.insert(-5));
+			REQUIRE(slist.insert(0));
+			THEN("Test finding it") {
+				REQUIRE(slist.exists(0));
+				bool out = false;
+				int key = 0;
+				slist.existsMany(&key, 1, &out);
+				REQUIRE(out);
+			}
+		}
 		WHEN("Insert 1000 random different elements") {
 			std::unordered_set<int> set;
 			const int TEST_NUM = 1000;
@@ -234,3 +252,657 @@ SCENARIO("Testing SkipList<int> class iteration left-parent-right") {
 	}//given
 }//scen
 
+
+SCENARIO("Testing SkipList<int> class with different node allocators") {
+	GIVEN("Lists with heap and slab allocators on 10 lvls and 0.5 fraction") {
+		SkipList<int, HeapAllocator> heapList(10, 0.5);
+		SkipList<int, SlabAllocator<4096>> slabList(10, 0.5);
+		const int TEST_NUM = 1000;
+		WHEN("Insert and remove the same elements in both") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(heapList.insert(i));
+				REQUIRE(slabList.insert(i));
+			}
+			for (int i = 0; i < TEST_NUM; i += 2) {
+				REQUIRE(heapList.remove(i));
+				REQUIRE(slabList.remove(i));
+			}
+			THEN("Test if both have the same elements") {
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(heapList.exists(i) == (i % 2 == 1));
+					REQUIRE(slabList.exists(i) == (i % 2 == 1));
+				}
+				REQUIRE(heapList.getSize() == TEST_NUM / 2);
+				REQUIRE(slabList.getSize() == TEST_NUM / 2);
+			}
+			THEN("Test clearing and reusing them") {
+				size_t emptyBytes = SkipList<int, SlabAllocator<4096>>(10, 0.5).getBytesUsed();
+				slabList.clearData();
+				REQUIRE(slabList.getBytesUsed() == emptyBytes);
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(!slabList.exists(i));
+					REQUIRE(slabList.insert(i));
+				}
+				REQUIRE(slabList.getSize() == TEST_NUM);
+			}
+		}//when
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class reuse of removed SLNodes") {
+	GIVEN("Creating object with heap allocator on 10 lvls and 0.5 fraction") {
+		SkipList<int, HeapAllocator> slist(10, 0.5);
+		const size_t emptyBytes = slist.getBytesUsed();
+		const int TEST_NUM = 1000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			slist.insert(i);
+		}
+		const size_t fullBytes = slist.getBytesUsed();
+		WHEN("Remove all elements") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(slist.remove(i));
+			}
+			THEN("Removed SLNodes are kept and still counted") {
+				REQUIRE(slist.getSize() == 0);
+				REQUIRE(slist.getBytesUsed() == fullBytes);
+			}
+			THEN("Shrinking gives their memory back") {
+				slist.shrinkToFit();
+				REQUIRE(slist.getBytesUsed() == emptyBytes);
+			}
+		}
+		WHEN("Remove and reinsert elements many times") {
+			for (int j = 0; j < 20; j++) {
+				for (int i = 0; i < TEST_NUM / 10; i++) {
+					REQUIRE(slist.remove(i));
+				}
+				for (int i = 0; i < TEST_NUM / 10; i++) {
+					REQUIRE(slist.insert(i));
+				}
+			}
+			THEN("Test if elements are correct and memory did not grow much") {
+				REQUIRE(slist.getSize() == TEST_NUM);
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(slist.exists(i));
+				}
+				REQUIRE(slist.getBytesUsed() < fullBytes + fullBytes / 2);
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class lvl generators") {
+	GIVEN("Two lists with the same seed on 10 lvls and 0.5 fraction") {
+		SkipList<int> first(10, 0.5, 42);
+		SkipList<int> second(10, 0.5, 42);
+		const int TEST_NUM = 1000;
+		WHEN("Insert the same elements") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				first.insert(i);
+				second.insert(i);
+			}
+			THEN("Test if all SLNodes got the same lvls") {
+				auto it = second.begin();
+				for (auto node : first) {
+					REQUIRE(node->value == (*it)->value);
+					REQUIRE(node->lvl == (*it)->lvl);
+					++it;
+				}
+			}
+			THEN("Test if reseeding repeats the lvls") {
+				first.clearData();
+				first.seed(42);
+				second.clearData();
+				second.seed(42);
+				for (int i = 0; i < TEST_NUM; i++) {
+					first.insert(i);
+					second.insert(i);
+				}
+				auto it = second.begin();
+				for (auto node : first) {
+					REQUIRE(node->lvl == (*it)->lvl);
+					++it;
+				}
+			}
+		}
+	}//given
+	GIVEN("Lists with different fractions and generators") {
+		SkipList<int> half(20, 0.5, 7);
+		SkipList<int> quarter(20, 0.25, 7);
+		SkipList<int> third(20, 0.3, 7);
+		SkipList<int, SlabAllocator<>, RandLevelGenerator> randList(20, 0.5);
+		const int TEST_NUM = 4096;
+		WHEN("Insert elements") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(half.insert(i));
+				REQUIRE(quarter.insert(i));
+				REQUIRE(third.insert(i));
+				REQUIRE(randList.insert(i));
+			}
+			THEN("Test if the number of SLNodes above lvl 0 follows the fraction") {
+				int cntHalf = 0, cntQuarter = 0, cntThird = 0, cntRand = 0;
+				for (auto node : half) cntHalf += node->lvl > 0;
+				for (auto node : quarter) cntQuarter += node->lvl > 0;
+				for (auto node : third) cntThird += node->lvl > 0;
+				for (auto node : randList) cntRand += node->lvl > 0;
+				REQUIRE(std::abs(cntHalf - TEST_NUM / 2) < TEST_NUM / 10);
+				REQUIRE(std::abs(cntQuarter - TEST_NUM / 4) < TEST_NUM / 10);
+				REQUIRE(std::abs(cntThird - TEST_NUM * 3 / 10) < TEST_NUM / 10);
+				REQUIRE(std::abs(cntRand - TEST_NUM / 2) < TEST_NUM / 10);
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(third.exists(i));
+				}
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class positional access") {
+	GIVEN("A list and a std::set with the same random elements") {
+		SkipList<int> slist(16, 0.5);
+		std::set<int> check;
+		const int TEST_NUM = 3000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = rand() % (TEST_NUM * 4);
+			slist.insert(val);
+			check.insert(val);
+		}
+		WHEN("Remove some of them by value and by position") {
+			for (int i = 0; i < TEST_NUM / 2; i++) {
+				int val = rand() % (TEST_NUM * 4);
+				slist.remove(val);
+				check.erase(val);
+			}
+			for (int i = 0; i < TEST_NUM / 4 && !check.empty(); i++) {
+				size_t k = rand() % check.size();
+				REQUIRE(slist.eraseAt(k));
+				check.erase(std::next(check.begin(), k));
+			}
+			THEN("Test at() and indexOf() for every position") {
+				REQUIRE(slist.getSize() == check.size());
+				size_t k = 0;
+				for (int val : check) {
+					REQUIRE(slist.at(k) != nullptr);
+					REQUIRE(*slist.at(k) == val);
+					REQUIRE(slist.indexOf(val) == k);
+					k++;
+				}
+				REQUIRE(slist.at(check.size()) == nullptr);
+				REQUIRE_FALSE(slist.eraseAt(check.size()));
+				REQUIRE(slist.indexOf(-1) == slist.getSize());
+			}
+			THEN("Test if erasing from the front empties the list") {
+				while (slist.getSize()) {
+					int front = *slist.at(0);
+					REQUIRE(slist.eraseAt(0));
+					REQUIRE_FALSE(slist.exists(front));
+				}
+				REQUIRE(slist.begin() == slist.end());
+				REQUIRE(slist.insert(5));
+				REQUIRE(*slist.at(0) == 5);
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class range scans") {
+	GIVEN("A list with the even numbers from 0 to 2 * TEST_NUM") {
+		SkipList<int> slist(16, 0.5);
+		const int TEST_NUM = 2000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			REQUIRE(slist.insert(i * 2));
+		}
+		THEN("Test lowerBound() and upperBound()") {
+			REQUIRE(*slist.lowerBound(-5) == 0);
+			REQUIRE(*slist.lowerBound(10) == 10);
+			REQUIRE(*slist.lowerBound(11) == 12);
+			REQUIRE(*slist.upperBound(10) == 12);
+			REQUIRE(*slist.upperBound(11) == 12);
+			REQUIRE(slist.lowerBound(TEST_NUM * 2) == nullptr);
+			REQUIRE(slist.upperBound(TEST_NUM * 2 - 2) == nullptr);
+		}
+		THEN("Test forEachInRange() for different ranges") {
+			for (int lo = -3; lo < TEST_NUM * 2 + 3; lo += 37) {
+				int hi = lo + rand() % 200;
+				std::vector<int> got;
+				slist.forEachInRange(lo, hi, [&got](int val) { got.push_back(val); });
+				std::vector<int> expected;
+				for (int val = lo < 0 ? 0 : lo + (lo % 2); val < hi && val < TEST_NUM * 2; val += 2) {
+					expected.push_back(val);
+				}
+				REQUIRE(got == expected);
+			}
+			int cnt = 0;
+			slist.forEachInRange(100, 100, [&cnt](int) { cnt++; });
+			slist.forEachInRange(100, 50, [&cnt](int) { cnt++; });
+			REQUIRE(cnt == 0);
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class bulk load from sorted values") {
+	GIVEN("A list with some elements and sorted vectors") {
+		SkipList<int> slist(16, 0.5);
+		slist.insert(-10);
+		std::vector<int> sorted;
+		const int TEST_NUM = 5000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			sorted.push_back(i * 3);
+		}
+		WHEN("Build from the sorted vector") {
+			REQUIRE(slist.buildFromSorted(sorted.begin(), sorted.end()));
+			THEN("Test if the list has only the new values in order") {
+				REQUIRE(slist.getSize() == TEST_NUM);
+				REQUIRE_FALSE(slist.exists(-10));
+				int expected = 0;
+				for (auto node : slist) {
+					REQUIRE(node->value == expected);
+					expected += 3;
+				}
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(slist.exists(i * 3));
+					REQUIRE(*slist.at(i) == i * 3);
+				}
+			}
+			THEN("Test if insertion and deletion keep working") {
+				for (int i = 0; i < TEST_NUM; i++) {
+					REQUIRE(slist.insert(i * 3 + 1));
+				}
+				for (int i = 0; i < TEST_NUM; i += 2) {
+					REQUIRE(slist.remove(i * 3));
+				}
+				REQUIRE(slist.getSize() == TEST_NUM + TEST_NUM / 2);
+				REQUIRE(*slist.at(0) == 1);
+				REQUIRE(slist.indexOf(4) == 2);
+			}
+		}
+		WHEN("Build from wrong or empty ranges") {
+			std::vector<int> unsorted = { 1, 5, 3 };
+			std::vector<int> repeated = { 1, 2, 2, 3 };
+			THEN("Test if wrong ranges do not change the list") {
+				REQUIRE_FALSE(slist.buildFromSorted(unsorted.begin(), unsorted.end()));
+				REQUIRE_FALSE(slist.buildFromSorted(repeated.begin(), repeated.end()));
+				REQUIRE(slist.getSize() == 1);
+				REQUIRE(slist.exists(-10));
+			}
+			THEN("Test if an empty range clears the list") {
+				REQUIRE(slist.buildFromSorted(sorted.begin(), sorted.begin()));
+				REQUIRE(slist.getSize() == 0);
+				REQUIRE(slist.begin() == slist.end());
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class structure-preserving copies") {
+	GIVEN("Big lists with different allocators") {
+		SkipList<int> slist(20, 0.5);
+		SkipList<int, HeapAllocator> heapList(20, 0.5);
+		const int TEST_NUM = 100000;//big enough to be copied by many threads
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = (rand() % 32768) * 32768 + rand() % 32768;
+			slist.insert(val);
+			heapList.insert(val);
+		}
+		WHEN("Copy them") {
+			SkipList<int> copy(slist);
+			SkipList<int, HeapAllocator> heapCopy(heapList);
+			THEN("Test if the copies have the same SLNodes with the same lvls") {
+				REQUIRE(copy.getSize() == slist.getSize());
+				REQUIRE(heapCopy.getBytesUsed() == heapList.getBytesUsed());
+				auto it = slist.begin();
+				for (auto node : copy) {
+					REQUIRE(node->value == (*it)->value);
+					REQUIRE(node->lvl == (*it)->lvl);
+					++it;
+				}
+				REQUIRE(it == slist.end());
+				for (size_t k = 0; k < copy.getSize(); k += 97) {
+					REQUIRE(*copy.at(k) == *slist.at(k));
+				}
+			}
+			THEN("Test if the copies work on their own") {
+				std::vector<int> values;
+				for (auto node : slist) values.push_back(node->value);
+				for (size_t i = 0; i < values.size(); i += 2) {
+					REQUIRE(copy.remove(values[i]));
+					REQUIRE(heapCopy.remove(values[i]));
+				}
+				REQUIRE(slist.getSize() == values.size());
+				REQUIRE(copy.getSize() == values.size() / 2);
+				REQUIRE(*copy.at(0) == values[1]);
+				REQUIRE(copy.indexOf(values[3]) == 1);
+				copy = slist;
+				REQUIRE(copy.getSize() == slist.getSize());
+				REQUIRE(copy.exists(values[0]));
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing SkipList<int> class batched lookups") {
+	GIVEN("A list with random elements") {
+		SkipList<int> slist(16, 0.5);
+		const int TEST_NUM = 20000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			slist.insert(rand() % (TEST_NUM * 2));
+		}
+		WHEN("Check batches of different sizes with existsMany()") {
+			std::vector<int> keys;
+			for (int i = 0; i < 1000; i++) {
+				keys.push_back(rand() % (TEST_NUM * 2 + 10) - 5);
+			}
+			THEN("Test if the results are the same as with exists()") {
+				for (size_t batch : { size_t(0), size_t(1), size_t(7), size_t(64), size_t(1000) }) {
+					std::vector<char> out(batch + 1, 2);
+					slist.existsMany(keys.data(), batch, reinterpret_cast<bool*>(out.data()));
+					for (size_t i = 0; i < batch; i++) {
+						REQUIRE((bool)out[i] == slist.exists(keys[i]));
+					}
+					REQUIRE(out[batch] == 2);
+				}
+			}
+		}
+		WHEN("Check in an empty list") {
+			slist.clearData();
+			int keys[] = { 1, 2, 3 };
+			bool out[] = { true, true, true };
+			slist.existsMany(keys, 3, out);
+			THEN("Test if nothing is found") {
+				REQUIRE_FALSE(out[0]);
+				REQUIRE_FALSE(out[1]);
+				REQUIRE_FALSE(out[2]);
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing UnrolledSkipList<int> class insertion and deletion") {
+	GIVEN("An empty list and a std::set that gets the same operations") {
+		UnrolledSkipList<int> ulist(16, 0.5, 7);
+		std::set<int> checker;
+		const int TEST_NUM = 20000;
+		THEN("Test if both agree after random inserts and removes") {
+			srand(3);
+			for (int i = 0; i < TEST_NUM * 5; i++) {
+				int val = rand() % TEST_NUM;
+				if (rand() % 3) REQUIRE(ulist.insert(val) == checker.insert(val).second);
+				else REQUIRE(ulist.remove(val) == (checker.erase(val) != 0));
+			}
+			REQUIRE(ulist.getSize() == checker.size());
+			auto expected = checker.begin();
+			for (auto val : ulist) {
+				REQUIRE(*val == *expected);
+				++expected;
+			}
+			REQUIRE(expected == checker.end());
+			for (int i = -5; i < TEST_NUM + 5; i++) {
+				REQUIRE(ulist.exists(i) == (checker.count(i) != 0));
+			}
+			//the blocks are split and merged, so they stay at least a quarter full
+			REQUIRE(ulist.getBlockCount() * 32 / 4 <= ulist.getSize() + 32);
+		}
+		THEN("Test removing everything with values going up and down") {
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(ulist.insert(i));
+				REQUIRE(ulist.insert(-i - 1));
+			}
+			REQUIRE_FALSE(ulist.insert(100));
+			REQUIRE(ulist.getSize() == TEST_NUM * 2);
+			REQUIRE(**ulist.begin() == -TEST_NUM);
+			for (int i = 0; i < TEST_NUM; i++) {
+				REQUIRE(ulist.remove(i));
+				REQUIRE_FALSE(ulist.remove(i));
+				REQUIRE(ulist.remove(-TEST_NUM + i));
+			}
+			REQUIRE(ulist.getSize() == 0);
+			REQUIRE(ulist.getBlockCount() == 0);
+			REQUIRE(ulist.begin() == ulist.end());
+			REQUIRE(ulist.insert(5));
+			REQUIRE(ulist.exists(5));
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing UnrolledSkipList<int> class range scans, copies and bulk load") {
+	GIVEN("A list with the even numbers from 0 to 2 * TEST_NUM") {
+		UnrolledSkipList<int> ulist(16, 0.5);
+		const int TEST_NUM = 2000;
+		for (int i = 0; i < TEST_NUM; i++) {
+			REQUIRE(ulist.insert(i * 2));
+		}
+		THEN("Test lowerBound(), upperBound() and forEachInRange()") {
+			REQUIRE(*ulist.lowerBound(-5) == 0);
+			REQUIRE(*ulist.upperBound(-5) == 0);
+			for (int i = 0; i < TEST_NUM * 2 - 2; i++) {
+				REQUIRE(*ulist.lowerBound(i) == i + (i % 2));
+				REQUIRE(*ulist.upperBound(i) == i + 2 - (i % 2));
+			}
+			REQUIRE(ulist.lowerBound(TEST_NUM * 2) == nullptr);
+			REQUIRE(ulist.upperBound(TEST_NUM * 2 - 2) == nullptr);
+			for (int lo = -3; lo < TEST_NUM * 2 + 3; lo += 37) {
+				int hi = lo + rand() % 200;
+				std::vector<int> got;
+				ulist.forEachInRange(lo, hi, [&got](int val) { got.push_back(val); });
+				std::vector<int> expected;
+				for (int val = lo < 0 ? 0 : lo + (lo % 2); val < hi && val < TEST_NUM * 2; val += 2) {
+					expected.push_back(val);
+				}
+				REQUIRE(got == expected);
+			}
+		}
+		THEN("Test copies and moves") {
+			UnrolledSkipList<int> copy(ulist);
+			REQUIRE(copy.getSize() == TEST_NUM);
+			REQUIRE(copy.getBlockCount() == ulist.getBlockCount());
+			REQUIRE(copy.remove(0));
+			REQUIRE(ulist.exists(0));
+			UnrolledSkipList<int> moved(std::move(copy));
+			REQUIRE(copy.getSize() == 0);
+			REQUIRE(moved.getSize() == TEST_NUM - 1);
+			copy = moved;
+			REQUIRE(copy.getSize() == TEST_NUM - 1);
+			REQUIRE(copy.insert(0));
+			ulist = std::move(copy);
+			REQUIRE(ulist.getSize() == TEST_NUM);
+			REQUIRE(ulist.exists(TEST_NUM * 2 - 2));
+		}
+		THEN("Test bulk load from sorted and wrong values") {
+			std::vector<int> sorted;
+			for (int i = 0; i < TEST_NUM * 3; i++) {
+				sorted.push_back(i * 3);
+			}
+			std::vector<int> unsorted = { 1, 5, 3 };
+			REQUIRE_FALSE(ulist.buildFromSorted(unsorted.begin(), unsorted.end()));
+			REQUIRE(ulist.getSize() == TEST_NUM);
+			REQUIRE(ulist.buildFromSorted(sorted.begin(), sorted.end()));
+			REQUIRE(ulist.getSize() == TEST_NUM * 3);
+			REQUIRE_FALSE(ulist.exists(2));
+			int expected = 0;
+			for (auto val : ulist) {
+				REQUIRE(*val == expected);
+				expected += 3;
+			}
+			for (int i = 0; i < TEST_NUM * 3; i++) {
+				REQUIRE(ulist.insert(i * 3 + 1));
+			}
+			REQUIRE(ulist.getSize() == TEST_NUM * 6);
+			REQUIRE(*ulist.upperBound(3) == 4);
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing UnrolledSkipList class memory and allocators") {
+	GIVEN("Lists with the same values") {
+		const int TEST_NUM = 100000;
+		SkipList<int> slist(20, 0.5);
+		UnrolledSkipList<int> ulist(16, 0.5);
+		UnrolledSkipList<std::string, HeapAllocator> strList(16, 0.5);
+		for (int i = 0; i < TEST_NUM; i++) {
+			int val = (int)((i * 7919ll) % TEST_NUM);
+			slist.insert(val);
+			ulist.insert(val);
+			if (i < TEST_NUM / 10) strList.insert(std::to_string(val));
+		}
+		THEN("Test if the memory over the values is more than 4 times less than in the Skip List") {
+			size_t valuesBytes = TEST_NUM * sizeof(int);
+			REQUIRE((ulist.getBytesUsed() - valuesBytes) * 4 < slist.getBytesUsed() - valuesBytes);
+		}
+		THEN("Test if values that own memory are kept and freed right") {
+			REQUIRE(strList.getSize() == TEST_NUM / 10);
+			REQUIRE(strList.exists(std::to_string((int)((5 * 7919ll) % TEST_NUM))));
+			UnrolledSkipList<std::string, HeapAllocator> copy(strList);
+			for (int i = 0; i < TEST_NUM / 10; i += 2) {
+				REQUIRE(copy.remove(std::to_string((int)((i * 7919ll) % TEST_NUM))));
+			}
+			REQUIRE(copy.getSize() == TEST_NUM / 20);
+			size_t emptyBytes = UnrolledSkipList<std::string, HeapAllocator>(16, 0.5).getBytesUsed();
+			strList.clearData();
+			REQUIRE(strList.getSize() == 0);
+			REQUIRE(strList.getBytesUsed() == emptyBytes);
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing ConcurrentSkipList<int> class with many threads") {
+	GIVEN("An empty concurrent list and some threads") {
+		ConcurrentSkipList<int> list(20, 0.5);
+		const int THREAD_CNT = 8;
+		const int PER_THREAD = 5000;
+		std::vector<std::thread> threads;
+		WHEN("Every thread inserts its own range") {
+			for (int t = 0; t < THREAD_CNT; t++) {
+				threads.emplace_back([&list, t]() {
+					for (int i = 0; i < PER_THREAD; i++) {
+						list.insert(i * THREAD_CNT + t);
+					}
+				});
+			}
+			for (auto& th : threads) th.join();
+			THEN("Test if all elements are in and in order") {
+				REQUIRE(list.getSize() == THREAD_CNT * PER_THREAD);
+				int expected = 0;
+				for (auto node : list) {
+					REQUIRE(node->value == expected++);
+				}
+				REQUIRE(expected == THREAD_CNT * PER_THREAD);
+			}
+		}
+		WHEN("All threads insert and remove the same elements") {
+			std::atomic<int> inserted{ 0 }, removed{ 0 };
+			for (int t = 0; t < THREAD_CNT; t++) {
+				threads.emplace_back([&list, &inserted, &removed]() {
+					for (int round = 0; round < 4; round++) {
+						for (int i = 0; i < PER_THREAD; i++) {
+							inserted += list.insert(i);
+						}
+						for (int i = 0; i < PER_THREAD; i += 2) {
+							removed += list.remove(i);
+						}
+					}
+				});
+			}
+			for (auto& th : threads) th.join();
+			THEN("Test if each element was inserted and removed only once at a time") {
+				REQUIRE(inserted - removed == (int)list.getSize());
+				REQUIRE(list.getSize() <= PER_THREAD);
+				for (int i = 1; i < PER_THREAD; i += 2) {
+					REQUIRE(list.exists(i));
+				}
+				int prev = -1;
+				size_t cnt = 0;
+				for (auto node : list) {
+					REQUIRE(prev < node->value);
+					prev = node->value;
+					cnt++;
+				}
+				REQUIRE(cnt == list.getSize());
+			}
+			THEN("Test if removing everything empties the list") {
+				for (int i = 0; i < PER_THREAD; i++) {
+					list.remove(i);
+				}
+				REQUIRE(list.getSize() == 0);
+				REQUIRE(list.begin() == list.end());
+				REQUIRE_FALSE(list.exists(1));
+			}
+		}
+		WHEN("Some threads scan ranges while the others remove the even elements") {
+			for (int i = 0; i < PER_THREAD; i++) {
+				list.insert(i);
+			}
+			std::atomic<int> badScans{ 0 };
+			for (int t = 0; t < THREAD_CNT; t++) {
+				threads.emplace_back([&list, &badScans, t]() {
+					if (t % 2) {
+						for (int i = t - 1; i < PER_THREAD; i += THREAD_CNT) {
+							list.remove(i);
+						}
+						return;
+					}
+					for (int round = 0; round < 50; round++) {
+						int lo = (round * 97) % PER_THREAD, hi = lo + 200;
+						int prev = lo - 1, odd = 0;
+						list.forEachInRange(lo, hi, [&](const int& value) {
+							if (value <= prev || value >= hi) badScans++;
+							prev = value;
+							odd += value % 2;
+						});
+						//odd elements are never removed, so all of them are seen
+						if (odd != (hi - lo) / 2) badScans++;
+					}
+				});
+			}
+			for (auto& th : threads) th.join();
+			THEN("Test if every scan was in order and saw all elements that stayed") {
+				REQUIRE(badScans == 0);
+				int cnt = 0;
+				list.forEachInRange(0, PER_THREAD, [&cnt](const int& value) { cnt += value % 2; });
+				REQUIRE(cnt == PER_THREAD / 2);
+				REQUIRE(list.getSize() == PER_THREAD / 2);
+			}
+		}
+	}//given
+}//scen
+
+SCENARIO("Testing ConcurrentSkipList<int> class removing nodes while they are linked") {
+	GIVEN("A list where most nodes have high lvls and threads that work with a few keys") {
+		//with fraction 0.875 the nodes have 8 lvls on average, so a remove often comes while the inserter links them
+		ConcurrentSkipList<int> list(20, 0.875);
+		const int THREAD_CNT = 8;
+		const int KEY_CNT = 16;
+		const int OPS = 20000;
+		std::vector<std::thread> threads;
+		std::atomic<int> inserted{ 0 }, removed{ 0 };
+		for (int t = 0; t < THREAD_CNT; t++) {
+			threads.emplace_back([&list, &inserted, &removed, t, KEY_CNT]() {
+				XorShiftLevelGenerator rnd(t + 1);
+				rnd.setFraction(0.5);
+				for (int i = 0; i < OPS; i++) {
+					int key = (int)(rnd(63) * 7 + i) % KEY_CNT;
+					if (i % 2) removed += list.remove(key);
+					else inserted += list.insert(key);
+					//reading nodes keeps them from being freed only while they are linked
+					list.forEachInRange(0, KEY_CNT, [](const int&) {});
+				}
+			});
+		}
+		for (auto& th : threads) th.join();
+		THEN("Test if the list is whole after all threads are done") {
+			REQUIRE(inserted - removed == (int)list.getSize());
+			int prev = -1;
+			size_t cnt = 0;
+			for (auto node : list) {
+				REQUIRE(prev < node->value);
+				prev = node->value;
+				cnt++;
+			}
+			REQUIRE(cnt == list.getSize());
+			for (int i = 0; i < KEY_CNT; i++) {
+				list.remove(i);
+			}
+			REQUIRE(list.getSize() == 0);
+			REQUIRE(list.begin() == list.end());
+		}
+	}//given
+}//scen